@@ -0,0 +1,2107 @@
+#define _DEFAULT_SOURCE
+
+#include "rige.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* benchmarks of the RiGE primitives, self-contained:
+ *
+ *   cc -O2 -o bench bench.c rige.c -lm -lpthread
+ *
+ *   ./bench [--format text|csv|json] [--filter <substring>]
+ *           [--trials <n>] [--warmup <n>] [--time-us <us>]
+ *           [--compare <baseline.csv>] [--threshold <percent>]
+ *
+ * every case is calibrated to take about `--time-us` per trial, then run
+ * `--warmup` times untimed and `--trials` times timed. the median and the
+ * 10th/90th percentiles of the time per operation are reported. with
+ * `--compare` the medians are checked against a `--format csv` output of
+ * an older build and the exit status is 1 if any got slower than
+ * `--threshold` percent
+ */
+
+/* ----------------------------------------------------------------
+ * corpus
+ */
+
+#define _BENCH_MAX_SIZE 65536
+#define _BENCH_MAX_STRS 256
+
+typedef struct _bench_corpus_s _bench_corpus_t ;
+
+/* `n` strings of lowercase letters and spaces, `a` and `b` are equal and
+ * `c` is a copy the mutating functions may change. `z` never appears so
+ * the searches scan everything
+ */
+struct _bench_corpus_s {
+  usiz_t  n                      ;
+  usiz_t  bytes                  ;
+  usiz_t  size [_BENCH_MAX_STRS] ;
+  chr_t * a    [_BENCH_MAX_STRS] ;
+  chr_t * b    [_BENCH_MAX_STRS] ;
+  chr_t * c    [_BENCH_MAX_STRS] ;
+  str_t   s    [_BENCH_MAX_STRS] ;
+} ;
+
+static _bench_corpus_t _corpus ;
+static chr_t _bench_dst [_BENCH_MAX_SIZE + 1] ;
+static volatile u64_t _bench_sink ;
+
+/* the sizes every sized case runs with, 0 is a mix of short names, lines
+ * and a few long texts like the engine sees them
+ */
+static const usiz_t _bench_sizes [] = { 8 , 64 , 512 , 4096 , 65536 , 0 } ;
+
+static u64_t _bench_rand (u64_t * state)
+{
+  *state = *state * 6364136223846793005ULL + 1442695040888963407ULL ;
+
+  return *state >> 33 ;
+}
+
+static void _bench_corpus_free (void)
+{
+  for (usiz_t i = 0 ; i < _corpus.n ; ++i) {
+    mem_dealloc(_corpus.a[i]) ;
+    mem_dealloc(_corpus.b[i]) ;
+    mem_dealloc(_corpus.c[i]) ;
+    mem_dealloc(_corpus.s[i].data) ;
+  }
+
+  _corpus.n     = 0 ;
+  _corpus.bytes = 0 ;
+}
+
+static usiz_t _bench_corpus_init (usiz_t size)
+{
+  u64_t state = 1 ;
+
+  _bench_corpus_free() ;
+
+  /* fixed sizes take a few strings, the mix takes lengths from 4 to 4096
+   * with short ones the most common
+   */
+  _corpus.n = 0 == size ? _BENCH_MAX_STRS : 4096 < size ? 4 : 16 ;
+
+  for (usiz_t i = 0 ; i < _corpus.n ; ++i) {
+    usiz_t n = size ;
+
+    if (0 == n) {
+      n = (4 << (_bench_rand(&state) % 11)) ;
+      n = n / 2 + _bench_rand(&state) % (n / 2 + 1) ;
+      n = 4096 < n ? 4096 : n ;
+    }
+
+    _corpus.size[i] = n ;
+    _corpus.a[i]    = (chr_t *)mem_alloc(n + 1) ;
+    _corpus.b[i]    = (chr_t *)mem_alloc(n + 1) ;
+    _corpus.c[i]    = (chr_t *)mem_alloc(n + 1) ;
+
+    if (RIGE_NULL == _corpus.a[i] || RIGE_NULL == _corpus.b[i] || RIGE_NULL == _corpus.c[i])
+      return RIGE_NPOS ;
+
+    for (usiz_t j = 0 ; j < n ; ++j) {
+      u64_t r = _bench_rand(&state) % 30 ;
+
+      _corpus.a[i][j] = 25 <= r ? ' ' : (chr_t)('a' + r) ;
+    }
+
+    _corpus.a[i][n] = 0 ;
+    mem_copy(_corpus.b[i], _corpus.a[i], n + 1) ;
+    mem_copy(_corpus.c[i], _corpus.a[i], n + 1) ;
+
+    _corpus.s[i]   = str_n_make(_corpus.a[i], n) ;
+    _corpus.bytes += n ;
+  }
+
+  return _corpus.bytes ;
+}
+
+/* ----------------------------------------------------------------
+ * cases
+ */
+
+typedef struct _bench_s _bench_t ;
+
+/* `sized` cases run once per entry of `_bench_sizes` over the corpus, the
+ * others set `bytes` to what one operation processes, 0 for none. `pred`
+ * and `arg` are passed through to `run`
+ */
+struct _bench_s {
+  const char * name                   ;
+  u64_t     (* run)  (const _bench_t * , u64_t) ;
+  i32_t        sized                  ;
+  usiz_t       bytes                  ;
+  i32_t     (* pred) (i32_t)          ;
+  i32_t        arg                    ;
+} ;
+
+#define _BENCH_LOOP(_body)                     \
+  u64_t sink = 0 ;                             \
+                                               \
+  for (u64_t it = 0 ; it < iters ; ++it) {     \
+    usiz_t i = it % _corpus.n ;                \
+    usiz_t n = _corpus.size[i] ;               \
+                                               \
+    (void)n ;                                  \
+    _body ;                                    \
+  }                                            \
+                                               \
+  return sink ;
+
+static u64_t _b_mem_alloc (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP({
+    ptr_t ptr = mem_alloc(n) ;
+    sink += (uptr_t)ptr ;
+    mem_dealloc(ptr) ;
+  })
+}
+
+static u64_t _b_mem_calloc (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP({
+    ptr_t ptr = mem_calloc(n, 1) ;
+    sink += (uptr_t)ptr ;
+    mem_dealloc(ptr) ;
+  })
+}
+
+static u64_t _b_mem_realloc (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP({
+    ptr_t ptr = mem_alloc(n / 2 + 1) ;
+    ptr = mem_realloc(ptr, n + 1) ;
+    sink += (uptr_t)ptr ;
+    mem_dealloc(ptr) ;
+  })
+}
+
+static u64_t _b_mem_copy (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += mem_copy(_bench_dst, _corpus.a[i], n))
+}
+
+static u64_t _b_mem_move (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  /* overlapping by one byte, the case `mem_copy` cannot do */
+  _BENCH_LOOP(sink += mem_move(_corpus.c[i] + (0 != n), _corpus.c[i], n - (0 != n)))
+}
+
+static u64_t _b_mem_set (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += mem_set(_bench_dst, 'x', n))
+}
+
+static u64_t _b_mem_comp (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += (u32_t)mem_comp(_corpus.a[i], _corpus.b[i], n))
+}
+
+static u64_t _b_mem_for_each (const _bench_t * b, u64_t iters)
+{
+  _BENCH_LOOP(sink += mem_for_each(_corpus.a[i], n, b->pred))
+}
+
+static u64_t _b_mem_hash_djb2 (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += mem_hash_djb2(_corpus.a[i], n))
+}
+
+static u64_t _b_cstr_size (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_size(_corpus.a[i]))
+}
+
+static u64_t _b_cstr_n_size (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_n_size(_corpus.a[i], n + 1))
+}
+
+static u64_t _b_cstr_copy (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_copy(_bench_dst, _corpus.a[i]))
+}
+
+static u64_t _b_cstr_n_copy (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_n_copy(_bench_dst, _corpus.a[i], n))
+}
+
+static u64_t _b_cstr_comp (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += (u32_t)cstr_comp(_corpus.a[i], _corpus.b[i]))
+}
+
+static u64_t _b_cstr_n_comp (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += (u32_t)cstr_n_comp(_corpus.a[i], _corpus.b[i], n))
+}
+
+static u64_t _b_cstr_icomp (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += (u32_t)cstr_icomp(_corpus.a[i], _corpus.b[i]))
+}
+
+static u64_t _b_cstr_n_icomp (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += (u32_t)cstr_n_icomp(_corpus.a[i], _corpus.b[i], n))
+}
+
+static u64_t _b_cstr_chr (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_chr(_corpus.a[i], 'z'))
+}
+
+static u64_t _b_cstr_n_chr (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_n_chr(_corpus.a[i], 'z', n))
+}
+
+static u64_t _b_cstr_ichr (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_ichr(_corpus.a[i], 'Z'))
+}
+
+static u64_t _b_cstr_n_ichr (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_n_ichr(_corpus.a[i], 'Z', n))
+}
+
+static u64_t _b_cstr_str (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_str(_corpus.a[i], "az"))
+}
+
+static u64_t _b_cstr_n_str (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_n_str(_corpus.a[i], "az", n))
+}
+
+static u64_t _b_cstr_istr (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_istr(_corpus.a[i], "AZ"))
+}
+
+static u64_t _b_cstr_n_istr (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_n_istr(_corpus.a[i], "AZ", n))
+}
+
+static u64_t _b_cstr_to_upper (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_to_upper(_corpus.c[i]))
+}
+
+static u64_t _b_cstr_n_to_upper (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_n_to_upper(_corpus.c[i], n))
+}
+
+static u64_t _b_cstr_to_lower (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_to_lower(_corpus.c[i]))
+}
+
+static u64_t _b_cstr_n_to_lower (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_n_to_lower(_corpus.c[i], n))
+}
+
+static u64_t _b_cstr_for_each (const _bench_t * b, u64_t iters)
+{
+  _BENCH_LOOP(sink += cstr_for_each(_corpus.a[i], b->pred))
+}
+
+static u64_t _b_cstr_n_for_each (const _bench_t * b, u64_t iters)
+{
+  _BENCH_LOOP(sink += cstr_n_for_each(_corpus.a[i], n, b->pred))
+}
+
+static u64_t _b_cstr_dup (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP({
+    cstr_t dup = cstr_dup(_corpus.a[i]) ;
+    sink += (uptr_t)dup ;
+    mem_dealloc(dup) ;
+  })
+}
+
+static u64_t _b_cstr_n_dup (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP({
+    cstr_t dup = cstr_n_dup(_corpus.a[i], n) ;
+    sink += (uptr_t)dup ;
+    mem_dealloc(dup) ;
+  })
+}
+
+static u64_t _b_cstr_hash_djb2 (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_hash_djb2(_corpus.a[i]))
+}
+
+static u64_t _b_cstr_n_hash_djb2 (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += cstr_n_hash_djb2(_corpus.a[i], n))
+}
+
+static u64_t _b_str_make (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP({
+    str_t str = str_make(_corpus.a[i]) ;
+    sink += str.size ;
+    mem_dealloc(str.data) ;
+  })
+}
+
+static u64_t _b_str_n_make (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP({
+    str_t str = str_n_make(_corpus.a[i], n) ;
+    sink += str.size ;
+    mem_dealloc(str.data) ;
+  })
+}
+
+static u64_t _b_str_copy (const _bench_t * b, u64_t iters)
+{
+  str_t dst = str_make("") ;
+
+  (void)b ;
+
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += str_copy(&dst, &_corpus.s[it % _corpus.n]) ;
+
+  mem_dealloc(dst.data) ;
+
+  return sink ;
+}
+
+static u64_t _b_str_n_copy (const _bench_t * b, u64_t iters)
+{
+  str_t dst = str_make("") ;
+
+  (void)b ;
+
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    usiz_t i = it % _corpus.n ;
+
+    sink += str_n_copy(&dst, &_corpus.s[i], _corpus.size[i]) ;
+  }
+
+  mem_dealloc(dst.data) ;
+
+  return sink ;
+}
+
+static u64_t _b_str_comp (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += (u32_t)str_comp(&_corpus.s[i], _corpus.b[i]))
+}
+
+static u64_t _b_str_n_comp (const _bench_t * b, u64_t iters)
+{
+  (void)b ;
+  _BENCH_LOOP(sink += (u32_t)str_n_comp(&_corpus.s[i], _corpus.b[i], n))
+}
+
+/* one operation classifies every byte value 16 times */
+static u64_t _b_chr (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    for (i32_t chr = 0 ; chr < 16 * 256 ; ++chr)
+      sink += b->pred(chr & 0xFF) ;
+  }
+
+  return sink ;
+}
+
+static u64_t _b_chr_to_digit (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  (void)b ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    for (i32_t chr = 0 ; chr < 16 * 256 ; ++chr)
+      sink += (u32_t)chr_to_digit(chr & 0xFF, 0) ;
+  }
+
+  return sink ;
+}
+
+#undef _BENCH_LOOP
+
+/* ----------------------------------------------------------------
+ * utf8
+ */
+
+#define _BENCH_UTF8_SIZE 65536
+
+enum {
+  _BENCH_UTF8_ASCII ,
+  _BENCH_UTF8_MIXED
+} ;
+
+/* a page of territory names, all ASCII or mixed with accented latin,
+ * cyrillic, CJK and emoji. `cps` are the code points of the mixed one
+ */
+static chr_t _bench_utf8 [2][_BENCH_UTF8_SIZE] ;
+static i32_t _bench_cps [_BENCH_UTF8_SIZE] ;
+static usiz_t _bench_n_cps ;
+
+static void _bench_utf8_init (void)
+{
+  static const char * words [2][8] = {
+    { "Kamchatka " , "Irkutsk " , "Yakutsk " , "Great Britain " , "Iceland " , "Ukraine " , "Egypt " , "Peru " } ,
+    { "Kamchatka " , "\xC3\x96sterreich " , "\xC3\x8Ele-de-France " , "\xE6\x97\xA5\xE6\x9C\xAC " , "\xE4\xB8\xAD\xE5\x9B\xBD " , "\xD0\xA0\xD0\xBE\xD1\x81\xD1\x81\xD0\xB8\xD1\x8F " , "\xF0\x9F\x8E\xB2 " , "Peru " }
+  } ;
+
+  for (usiz_t k = 0 ; k < 2 ; ++k) {
+    usiz_t size = 0 ;
+
+    for (usiz_t w = 0 ;; w = (w + 1) % 8) {
+      usiz_t n = cstr_size((cstr_t)words[k][w]) ;
+
+      if (_BENCH_UTF8_SIZE < size + n)
+        break ;
+
+      mem_copy(_bench_utf8[k] + size, (ptr_t)words[k][w], n) ;
+      size += n ;
+    }
+
+    mem_set(_bench_utf8[k] + size, ' ', _BENCH_UTF8_SIZE - size) ;
+  }
+
+  _bench_n_cps = 0 ;
+
+  for (usiz_t i = 0 ; i < _BENCH_UTF8_SIZE ;)
+    i += utf8_decode(_bench_utf8[_BENCH_UTF8_MIXED] + i, _BENCH_UTF8_SIZE - i, &_bench_cps[_bench_n_cps++]) ;
+}
+
+/* the byte at a time validation every fast path is measured against */
+static usiz_t _bench_ref_utf8_valid (const u8_t * ptr, usiz_t n)
+{
+  usiz_t i = 0 ;
+
+  while (i < n) {
+    u32_t chr = ptr[i] ;
+    usiz_t size = chr < 0x80 ? 1 : 0xC0 == (chr & 0xE0) ? 2 : 0xE0 == (chr & 0xF0) ? 3 : 0xF0 == (chr & 0xF8) ? 4 : 0 ;
+
+    if (0 == size || n - i < size)
+      break ;
+
+    u32_t cp = 1 == size ? chr : chr & (0x7F >> size) ;
+    usiz_t j ;
+
+    for (j = 1 ; j < size && 0x80 == (ptr[i + j] & 0xC0) ; ++j)
+      cp = (cp << 6) | (ptr[i + j] & 0x3F) ;
+
+    if (j != size || (2 == size && cp < 0x80) || (3 == size && cp < 0x800) || (4 == size && cp < 0x10000) || 0x10FFFF < cp || (0xD800 <= cp && cp <= 0xDFFF))
+      break ;
+
+    i += size ;
+  }
+
+  return i ;
+}
+
+static u64_t _b_utf8_decode (const _bench_t * b, u64_t iters)
+{
+  const chr_t * text = _bench_utf8[b->arg] ;
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    for (usiz_t i = 0 ; i < _BENCH_UTF8_SIZE ;) {
+      i32_t cp ;
+
+      i    += utf8_decode((ptr_t)(text + i), _BENCH_UTF8_SIZE - i, &cp) ;
+      sink += cp ;
+    }
+  }
+
+  return sink ;
+}
+
+static u64_t _b_utf8_encode (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  (void)b ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    usiz_t size = 0 ;
+
+    for (usiz_t i = 0 ; i < _bench_n_cps ; ++i)
+      size += utf8_encode(_bench_dst + size, _BENCH_UTF8_SIZE - size, _bench_cps[i]) ;
+
+    sink += size ;
+  }
+
+  return sink ;
+}
+
+static u64_t _b_utf8_valid (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += utf8_valid(_bench_utf8[b->arg], _BENCH_UTF8_SIZE) ;
+
+  return sink ;
+}
+
+static u64_t _b_utf8_count (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += utf8_count(_bench_utf8[b->arg], _BENCH_UTF8_SIZE) ;
+
+  return sink ;
+}
+
+static u64_t _b_utf8_width (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += utf8_width(_bench_utf8[b->arg], _BENCH_UTF8_SIZE) ;
+
+  return sink ;
+}
+
+static u64_t _b_utf8_find_cntrl (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += utf8_find_cntrl(_bench_utf8[b->arg], _BENCH_UTF8_SIZE) ;
+
+  return sink ;
+}
+
+static u64_t _b_ref_utf8_valid (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += _bench_ref_utf8_valid((const u8_t *)_bench_utf8[b->arg], _BENCH_UTF8_SIZE) ;
+
+  return sink ;
+}
+
+static u64_t _b_ref_utf8_count (const _bench_t * b, u64_t iters)
+{
+  const u8_t * text = (const u8_t *)_bench_utf8[b->arg] ;
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    for (usiz_t i = 0 ; i < _BENCH_UTF8_SIZE ; ++i)
+      sink += 0x80 != (text[i] & 0xC0) ;
+  }
+
+  return sink ;
+}
+
+/* ----------------------------------------------------------------
+ * num
+ */
+
+#define _BENCH_NUMS 1024
+
+/* numbers of 1 to 20 digits, equally many of every length, as values
+ * and as text in decimal, hex and decimal with every other one negative
+ */
+static u64_t _bench_nums [_BENCH_NUMS] ;
+static chr_t _bench_num_text [3][_BENCH_NUMS][NUM_MAX_SIZE] ;
+static usiz_t _bench_num_size [3][_BENCH_NUMS] ;
+
+enum {
+  _BENCH_NUM_DEC ,
+  _BENCH_NUM_HEX ,
+  _BENCH_NUM_NEG
+} ;
+
+static void _bench_num_init (void)
+{
+  u64_t state = 2 ;
+
+  for (usiz_t i = 0 ; i < _BENCH_NUMS ; ++i) {
+    u64_t val = (_bench_rand(&state) << 32) ^ _bench_rand(&state) ;
+    u64_t lim = 1 ;
+
+    for (usiz_t d = i % 20 ; 0 < d ; --d)
+      lim *= 10 ;
+
+    /* 20 digit numbers stay below 2^64 */
+    _bench_nums[i] = 19 == i % 20 ? val : val % (lim * 10) ;
+
+    _bench_num_size[_BENCH_NUM_DEC][i] = num_fmt_u64(_bench_num_text[_BENCH_NUM_DEC][i], NUM_MAX_SIZE, _bench_nums[i], 10) ;
+    _bench_num_size[_BENCH_NUM_HEX][i] = num_fmt_u64(_bench_num_text[_BENCH_NUM_HEX][i], NUM_MAX_SIZE, _bench_nums[i], 16) ;
+    _bench_num_size[_BENCH_NUM_NEG][i] = num_fmt_i64(_bench_num_text[_BENCH_NUM_NEG][i], NUM_MAX_SIZE, (i64_t)(_bench_nums[i] >> 1) * (0 != i % 2 ? -1 : 1), 10) ;
+  }
+}
+
+static u64_t _b_num_parse_u64 (const _bench_t * b, u64_t iters)
+{
+  i32_t base = _BENCH_NUM_HEX == b->arg ? 16 : 10 ;
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    usiz_t i = it % _BENCH_NUMS ;
+    u64_t val ;
+
+    num_parse_u64(_bench_num_text[b->arg][i], _bench_num_size[b->arg][i], base, &val) ;
+    sink += val ;
+  }
+
+  return sink ;
+}
+
+static u64_t _b_num_parse_i64 (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  (void)b ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    usiz_t i = it % _BENCH_NUMS ;
+    i64_t val ;
+
+    num_parse_i64(_bench_num_text[_BENCH_NUM_NEG][i], _bench_num_size[_BENCH_NUM_NEG][i], 10, &val) ;
+    sink += (u64_t)val ;
+  }
+
+  return sink ;
+}
+
+static u64_t _b_strtoull (const _bench_t * b, u64_t iters)
+{
+  i32_t base = _BENCH_NUM_HEX == b->arg ? 16 : 10 ;
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += strtoull(_bench_num_text[b->arg][it % _BENCH_NUMS], RIGE_NULL, base) ;
+
+  return sink ;
+}
+
+static u64_t _b_strtoll (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  (void)b ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += (u64_t)strtoll(_bench_num_text[_BENCH_NUM_NEG][it % _BENCH_NUMS], RIGE_NULL, 10) ;
+
+  return sink ;
+}
+
+static u64_t _b_num_fmt_u64 (const _bench_t * b, u64_t iters)
+{
+  i32_t base = _BENCH_NUM_HEX == b->arg ? 16 : 10 ;
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += num_fmt_u64(_bench_dst, NUM_MAX_SIZE, _bench_nums[it % _BENCH_NUMS], base) ;
+
+  return sink ;
+}
+
+static u64_t _b_num_fmt_i64 (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  (void)b ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    usiz_t i = it % _BENCH_NUMS ;
+
+    sink += num_fmt_i64(_bench_dst, NUM_MAX_SIZE, (i64_t)(_bench_nums[i] >> 1) * (0 != i % 2 ? -1 : 1), 10) ;
+  }
+
+  return sink ;
+}
+
+static u64_t _b_snprintf_u64 (const _bench_t * b, u64_t iters)
+{
+  const char * fmt = _BENCH_NUM_HEX == b->arg ? "%llx" : "%llu" ;
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += (u32_t)snprintf(_bench_dst, NUM_MAX_SIZE, fmt, (unsigned long long)_bench_nums[it % _BENCH_NUMS]) ;
+
+  return sink ;
+}
+
+static u64_t _b_snprintf_i64 (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  (void)b ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    usiz_t i = it % _BENCH_NUMS ;
+
+    sink += (u32_t)snprintf(_bench_dst, NUM_MAX_SIZE, "%lld", (long long)(_bench_nums[i] >> 1) * (0 != i % 2 ? -1 : 1)) ;
+  }
+
+  return sink ;
+}
+
+/* ----------------------------------------------------------------
+ * strbuf
+ */
+
+#define _BENCH_KB 1024
+
+/* the baseline is quadratic, a megabyte of it takes seconds per trial so
+ * it only builds 16 KiB
+ */
+static chr_t _bench_arena [1024 * _BENCH_KB + 64] ;
+
+static const char * _bench_names [8] = {
+  "Kamchatka" , "Irkutsk" , "Yakutsk" , "Great Britain" , "Iceland" , "Ukraine" , "Egypt" , "Peru"
+} ;
+
+/* how text was built before `strbuf_t`, the joined text replaces the old
+ * one with `str_copy`
+ */
+static void _bench_str_append (str_t * out, const chr_t * piece, usiz_t n)
+{
+  str_t cat ;
+
+  cat.data = (chr_t *)mem_alloc(out->size + n + 1) ;
+  cat.size = out->size + n ;
+
+  mem_copy(cat.data, out->data, out->size) ;
+  mem_copy(cat.data + out->size, (ptr_t)piece, n) ;
+  cat.data[cat.size] = 0 ;
+
+  str_copy(out, &cat) ;
+  mem_dealloc(cat.data) ;
+}
+
+/* lines of `<name> <armies>:<change>` until `size` bytes */
+static void _bench_strbuf_fill (strbuf_t * sb, usiz_t size)
+{
+  for (u64_t k = 0 ; sb->size < size ; ++k) {
+    strbuf_append(sb, (cstr_t)_bench_names[k % 8]) ;
+    strbuf_append_chr(sb, ' ') ;
+    strbuf_append_u64(sb, k * 2654435761u % 100000, 10) ;
+    strbuf_append_chr(sb, ':') ;
+    strbuf_append_i64(sb, (i64_t)(k % 17) - 8, 10) ;
+    strbuf_append_chr(sb, '\n') ;
+  }
+}
+
+static u64_t _b_strbuf (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    strbuf_t sb ;
+
+    strbuf_init(&sb) ;
+    _bench_strbuf_fill(&sb, (usiz_t)b->arg) ;
+
+    str_t str = strbuf_to_str(&sb) ;
+
+    sink += str.size ;
+    mem_dealloc(str.data) ;
+  }
+
+  return sink ;
+}
+
+/* the same text into a buffer big enough for all of it */
+static u64_t _b_strbuf_arena (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    strbuf_t sb ;
+
+    strbuf_init_with(&sb, _bench_arena, sizeof(_bench_arena)) ;
+    _bench_strbuf_fill(&sb, (usiz_t)b->arg) ;
+
+    sink += sb.size ;
+    strbuf_free(&sb) ;
+  }
+
+  return sink ;
+}
+
+static u64_t _b_str_append (const _bench_t * b, u64_t iters)
+{
+  chr_t num [NUM_MAX_SIZE] ;
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    str_t out = str_make("") ;
+
+    for (u64_t k = 0 ; out.size < (usiz_t)b->arg ; ++k) {
+      _bench_str_append(&out, _bench_names[k % 8], cstr_size((cstr_t)_bench_names[k % 8])) ;
+      _bench_str_append(&out, " ", 1) ;
+      _bench_str_append(&out, num, num_fmt_u64(num, NUM_MAX_SIZE, k * 2654435761u % 100000, 10)) ;
+      _bench_str_append(&out, ":", 1) ;
+      _bench_str_append(&out, num, num_fmt_i64(num, NUM_MAX_SIZE, (i64_t)(k % 17) - 8, 10)) ;
+      _bench_str_append(&out, "\n", 1) ;
+    }
+
+    sink += out.size ;
+    mem_dealloc(out.data) ;
+  }
+
+  return sink ;
+}
+
+/* ----------------------------------------------------------------
+ * chan
+ */
+
+#define _BENCH_QUEUE_SIZE 1024
+#define _BENCH_POP_BATCH  64
+
+typedef struct _bench_queue_s _bench_queue_t ;
+
+/* what the channels replace, a bounded ring behind a mutex */
+struct _bench_queue_s {
+  pthread_mutex_t lock                       ;
+  pthread_cond_t  not_empty                  ;
+  pthread_cond_t  not_full                   ;
+  usiz_t          head                       ;
+  usiz_t          tail                       ;
+  u64_t           buf [_BENCH_QUEUE_SIZE]    ;
+} ;
+
+typedef struct _bench_peer_s _bench_peer_t ;
+
+/* one producer, or the echoing side of a ping-pong */
+struct _bench_peer_s {
+  chan_t *         ch [2] ;
+  _bench_queue_t * q  [2] ;
+  u64_t            n      ;
+} ;
+
+static void _bench_queue_init (_bench_queue_t * q)
+{
+  pthread_mutex_init(&q->lock, RIGE_NULL) ;
+  pthread_cond_init(&q->not_empty, RIGE_NULL) ;
+  pthread_cond_init(&q->not_full, RIGE_NULL) ;
+  q->head = 0 ;
+  q->tail = 0 ;
+}
+
+static void _bench_queue_free (_bench_queue_t * q)
+{
+  pthread_mutex_destroy(&q->lock) ;
+  pthread_cond_destroy(&q->not_empty) ;
+  pthread_cond_destroy(&q->not_full) ;
+}
+
+static void _bench_queue_push (_bench_queue_t * q, u64_t msg)
+{
+  pthread_mutex_lock(&q->lock) ;
+
+  while (_BENCH_QUEUE_SIZE == q->tail - q->head)
+    pthread_cond_wait(&q->not_full, &q->lock) ;
+
+  q->buf[q->tail++ % _BENCH_QUEUE_SIZE] = msg ;
+
+  pthread_cond_signal(&q->not_empty) ;
+  pthread_mutex_unlock(&q->lock) ;
+}
+
+static usiz_t _bench_queue_pop (_bench_queue_t * q, u64_t * dst, usiz_t n)
+{
+  usiz_t done ;
+
+  pthread_mutex_lock(&q->lock) ;
+
+  while (q->head == q->tail)
+    pthread_cond_wait(&q->not_empty, &q->lock) ;
+
+  for (done = 0 ; done < n && q->head != q->tail ; ++done)
+    dst[done] = q->buf[q->head++ % _BENCH_QUEUE_SIZE] ;
+
+  pthread_cond_broadcast(&q->not_full) ;
+  pthread_mutex_unlock(&q->lock) ;
+
+  return done ;
+}
+
+static void * _bench_chan_producer (void * arg)
+{
+  _bench_peer_t * peer = (_bench_peer_t *)arg ;
+
+  /* producers never block, a full channel is retried */
+  for (u64_t i = 0 ; i < peer->n ;) {
+    if (1 == chan_push(peer->ch[0], &i, 1)) {
+      ++i ;
+    } else {
+      sched_yield() ;
+    }
+  }
+
+  return RIGE_NULL ;
+}
+
+static void * _bench_queue_producer (void * arg)
+{
+  _bench_peer_t * peer = (_bench_peer_t *)arg ;
+
+  for (u64_t i = 0 ; i < peer->n ; ++i)
+    _bench_queue_push(peer->q[0], i) ;
+
+  return RIGE_NULL ;
+}
+
+static void * _bench_chan_echo (void * arg)
+{
+  _bench_peer_t * peer = (_bench_peer_t *)arg ;
+  u64_t msg ;
+
+  for (u64_t i = 0 ; i < peer->n ; ++i) {
+    chan_wait_pop(peer->ch[0], &msg, 1) ;
+    chan_push(peer->ch[1], &msg, 1) ;
+  }
+
+  return RIGE_NULL ;
+}
+
+static void * _bench_queue_echo (void * arg)
+{
+  _bench_peer_t * peer = (_bench_peer_t *)arg ;
+  u64_t msg ;
+
+  for (u64_t i = 0 ; i < peer->n ; ++i) {
+    _bench_queue_pop(peer->q[0], &msg, 1) ;
+    _bench_queue_push(peer->q[1], msg) ;
+  }
+
+  return RIGE_NULL ;
+}
+
+/* `arg` producers send `iters` messages in total to this thread, which
+ * takes them in batches
+ */
+static u64_t _b_chan (const _bench_t * b, u64_t iters)
+{
+  pthread_t     thread [8] ;
+  _bench_peer_t peer   [8] ;
+  u64_t         buf    [_BENCH_POP_BATCH] ;
+  chan_t        ch ;
+  u64_t         sink = 0 ;
+
+  chan_init(&ch, sizeof(u64_t), _BENCH_QUEUE_SIZE, (1 < b->arg ? CHAN_MPSC : CHAN_SPSC) | CHAN_BLOCKING) ;
+
+  for (i32_t p = 0 ; p < b->arg ; ++p) {
+    peer[p].ch[0] = &ch ;
+    peer[p].n     = iters / b->arg + (0 == p ? iters % b->arg : 0) ;
+    pthread_create(&thread[p], RIGE_NULL, _bench_chan_producer, &peer[p]) ;
+  }
+
+  for (u64_t got = 0 ; got < iters ;) {
+    usiz_t n = chan_wait_pop(&ch, buf, _BENCH_POP_BATCH) ;
+
+    got  += n ;
+    sink += buf[0] ;
+  }
+
+  for (i32_t p = 0 ; p < b->arg ; ++p)
+    pthread_join(thread[p], RIGE_NULL) ;
+
+  chan_free(&ch) ;
+
+  return sink ;
+}
+
+static u64_t _b_queue (const _bench_t * b, u64_t iters)
+{
+  pthread_t      thread [8] ;
+  _bench_peer_t  peer   [8] ;
+  u64_t          buf    [_BENCH_POP_BATCH] ;
+  _bench_queue_t q ;
+  u64_t          sink = 0 ;
+
+  _bench_queue_init(&q) ;
+
+  for (i32_t p = 0 ; p < b->arg ; ++p) {
+    peer[p].q[0] = &q ;
+    peer[p].n    = iters / b->arg + (0 == p ? iters % b->arg : 0) ;
+    pthread_create(&thread[p], RIGE_NULL, _bench_queue_producer, &peer[p]) ;
+  }
+
+  for (u64_t got = 0 ; got < iters ;) {
+    usiz_t n = _bench_queue_pop(&q, buf, _BENCH_POP_BATCH) ;
+
+    got  += n ;
+    sink += buf[0] ;
+  }
+
+  for (i32_t p = 0 ; p < b->arg ; ++p)
+    pthread_join(thread[p], RIGE_NULL) ;
+
+  _bench_queue_free(&q) ;
+
+  return sink ;
+}
+
+/* round trips to a thread that sends every message back */
+static u64_t _b_chan_pingpong (const _bench_t * b, u64_t iters)
+{
+  pthread_t     thread ;
+  _bench_peer_t peer ;
+  chan_t        ch [2] ;
+  u64_t         sink = 0 ;
+
+  (void)b ;
+
+  chan_init(&ch[0], sizeof(u64_t), 2, CHAN_SPSC | CHAN_BLOCKING) ;
+  chan_init(&ch[1], sizeof(u64_t), 2, CHAN_SPSC | CHAN_BLOCKING) ;
+
+  peer.ch[0] = &ch[0] ;
+  peer.ch[1] = &ch[1] ;
+  peer.n     = iters ;
+  pthread_create(&thread, RIGE_NULL, _bench_chan_echo, &peer) ;
+
+  for (u64_t i = 0 ; i < iters ; ++i) {
+    u64_t msg = i ;
+
+    chan_push(&ch[0], &msg, 1) ;
+    chan_wait_pop(&ch[1], &msg, 1) ;
+    sink += msg ;
+  }
+
+  pthread_join(thread, RIGE_NULL) ;
+  chan_free(&ch[0]) ;
+  chan_free(&ch[1]) ;
+
+  return sink ;
+}
+
+static u64_t _b_queue_pingpong (const _bench_t * b, u64_t iters)
+{
+  pthread_t      thread ;
+  _bench_peer_t  peer ;
+  _bench_queue_t q [2] ;
+  u64_t          sink = 0 ;
+
+  (void)b ;
+
+  _bench_queue_init(&q[0]) ;
+  _bench_queue_init(&q[1]) ;
+
+  peer.q[0] = &q[0] ;
+  peer.q[1] = &q[1] ;
+  peer.n    = iters ;
+  pthread_create(&thread, RIGE_NULL, _bench_queue_echo, &peer) ;
+
+  for (u64_t i = 0 ; i < iters ; ++i) {
+    u64_t msg ;
+
+    _bench_queue_push(&q[0], i) ;
+    _bench_queue_pop(&q[1], &msg, 1) ;
+    sink += msg ;
+  }
+
+  pthread_join(thread, RIGE_NULL) ;
+  _bench_queue_free(&q[0]) ;
+  _bench_queue_free(&q[1]) ;
+
+  return sink ;
+}
+
+/* ----------------------------------------------------------------
+ * eval
+ */
+
+#define _BENCH_BATCHES 64
+
+/* the same random positions as batches and one by one. the one line build
+ * has SSE lanes, add `-march=native` for AVX2
+ */
+static eval_t _bench_eval ;
+static eval_batch_t _bench_batches [_BENCH_BATCHES] ;
+static f32_t _bench_feat [_BENCH_BATCHES * EVAL_BATCH][EVAL_FEATURES] ;
+
+static void _bench_eval_init (void)
+{
+  static const f32_t range [EVAL_FEATURES] = { 6.0f , 6.0f , 30.0f , 8.0f } ;
+  u64_t state = 3 ;
+
+  eval_init(&_bench_eval) ;
+
+  for (usiz_t k = 0 ; k < _BENCH_BATCHES ; ++k) {
+    for (usiz_t i = 0 ; i < EVAL_BATCH ; ++i) {
+      for (i32_t f = 0 ; f < EVAL_FEATURES ; ++f) {
+        f32_t val = range[f] * (f32_t)(_bench_rand(&state) % 1024) / 1024.0f ;
+
+        _bench_batches[k].feat[f][i]       = val ;
+        _bench_feat[k * EVAL_BATCH + i][f] = val ;
+      }
+    }
+
+    _bench_batches[k].size = EVAL_BATCH ;
+  }
+}
+
+/* `arg` positions of every batch are scored, one operation is a position */
+static u64_t _b_eval_run (const _bench_t * b, u64_t iters)
+{
+  f32_t out [EVAL_BATCH] ;
+  f32_t sink = 0.0f ;
+
+  for (u64_t it = 0 ; it < iters ; it += (u64_t)b->arg) {
+    eval_batch_t * batch = &_bench_batches[(it / (u64_t)b->arg) % _BENCH_BATCHES] ;
+
+    batch->size = (usiz_t)b->arg ;
+    eval_run(&_bench_eval, batch, out) ;
+    sink += out[0] ;
+  }
+
+  return (u64_t)sink ;
+}
+
+static u64_t _b_eval_one (const _bench_t * b, u64_t iters)
+{
+  f32_t sink = 0.0f ;
+
+  (void)b ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += eval_one(&_bench_eval, _bench_feat[it % (_BENCH_BATCHES * EVAL_BATCH)]) ;
+
+  return (u64_t)sink ;
+}
+
+/* ----------------------------------------------------------------
+ * board
+ */
+
+#define _BENCH_BOARD_PLAYERS 4
+
+enum {
+  _BENCH_MAP_SMALL  ,
+  _BENCH_MAP_MEDIUM ,
+  _BENCH_MAP_LARGE  ,
+  _BENCH_MAPS       ,
+} ;
+
+/* the classic 42 territories, a map for `bset128_t` and one too large for
+ * the bitset paths, all generated and shared out at random among the
+ * players
+ */
+static map_t _bench_maps [_BENCH_MAPS] ;
+static board_t _bench_boards [_BENCH_MAPS] ;
+
+static void _bench_board_init (void)
+{
+  static const usiz_t n_terr [_BENCH_MAPS] = { 42 , 120 , 1000 } ;
+  static const usiz_t n_cont [_BENCH_MAPS] = { 6 , 10 , 40 } ;
+  static const i32v_t size [_BENCH_MAPS] = { { 80 , 24 } , { 160 , 48 } , { 400 , 200 } } ;
+  u64_t state = 5 ;
+
+  for (usiz_t m = 0 ; m < _BENCH_MAPS ; ++m) {
+    if (
+      RIGE_NPOS == map_generate(&_bench_maps[m], n_terr[m], n_cont[m], size[m], 7, 1) ||
+      RIGE_NPOS == board_init(&_bench_boards[m], &_bench_maps[m], _BENCH_BOARD_PLAYERS)
+    ) {
+      fprintf(stderr, "bench: cannot generate a map of %zu territories\n", (size_t)n_terr[m]) ;
+      exit(1) ;
+    }
+
+    for (u32_t t = 0 ; t < n_terr[m] ; ++t) {
+      board_set_owner(&_bench_boards[m], t, (u8_t)(_bench_rand(&state) % _BENCH_BOARD_PLAYERS), RIGE_NULL) ;
+      _bench_boards[m].armies[t] = 1 + (u32_t)(_bench_rand(&state) % 4) ;
+    }
+  }
+}
+
+/* `arg` is the map, one operation is the income of one player */
+static u64_t _b_board_income (const _bench_t * b, u64_t iters)
+{
+  const board_t * board = &_bench_boards[b->arg] ;
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += board_income(board, (u8_t)(it % _BENCH_BOARD_PLAYERS)) ;
+
+  return sink ;
+}
+
+static u64_t _b_board_income_scan (const _bench_t * b, u64_t iters)
+{
+  const board_t * board = &_bench_boards[b->arg] ;
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += board_income_scan(board, (u8_t)(it % _BENCH_BOARD_PLAYERS)) ;
+
+  return sink ;
+}
+
+/* a conquest and its undo, one operation is one of the two */
+static u64_t _b_board_set_owner (const _bench_t * b, u64_t iters)
+{
+  board_t * board = &_bench_boards[b->arg] ;
+  u64_t sink = 0 ;
+  u8_t prev = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; it += 2) {
+    u32_t t = (u32_t)((it * 7) % board->map->n_terr) ;
+
+    board_set_owner(board, t, (u8_t)((it / 2) % _BENCH_BOARD_PLAYERS), &prev) ;
+    sink += board->bonus[0] ;
+    board_set_owner(board, t, prev, RIGE_NULL) ;
+  }
+
+  return sink ;
+}
+
+/* ----------------------------------------------------------------
+ * bset
+ */
+
+#define _BENCH_MOVES 1024
+
+/* the same positions as sets, `bset64_t` on the small map and
+ * `bset128_t` on the medium one
+ */
+static bset64_map_t _bench_bset64 ;
+static bset64_t _bench_own64 [_BENCH_BOARD_PLAYERS] ;
+static bset64_t _bench_ready64 ;
+static bset128_map_t _bench_bset128 ;
+static bset128_t _bench_own128 [_BENCH_BOARD_PLAYERS] ;
+static bset128_t _bench_ready128 ;
+
+static void _bench_bset_init (void)
+{
+  const board_t * small = &_bench_boards[_BENCH_MAP_SMALL] ;
+  const board_t * medium = &_bench_boards[_BENCH_MAP_MEDIUM] ;
+
+  bset64_map(small->map, &_bench_bset64) ;
+  bset128_map(medium->map, &_bench_bset128) ;
+  bset64_zero(&_bench_ready64) ;
+  bset128_zero(&_bench_ready128) ;
+
+  for (u8_t p = 0 ; p < _BENCH_BOARD_PLAYERS ; ++p) {
+    _bench_own64[p] = bset64_owned(small->owner, small->map->n_terr, p) ;
+    _bench_own128[p] = bset128_owned(medium->owner, medium->map->n_terr, p) ;
+  }
+
+  for (u32_t t = 0 ; t < small->map->n_terr ; ++t) {
+    if (1 < small->armies[t])
+      bset64_set(&_bench_ready64, t) ;
+  }
+
+  for (u32_t t = 0 ; t < medium->map->n_terr ; ++t) {
+    if (1 < medium->armies[t])
+      bset128_set(&_bench_ready128, t) ;
+  }
+}
+
+/* `arg` is the map, one operation is the moves of one player */
+static u64_t _b_map_attacks (const _bench_t * b, u64_t iters)
+{
+  static u32_t moves [2 * _BENCH_MOVES] ;
+  const board_t * board = &_bench_boards[b->arg] ;
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += map_attacks(board->map, board->owner, board->armies, (u8_t)(it % _BENCH_BOARD_PLAYERS), moves, _BENCH_MOVES) ;
+
+  return sink + moves[0] ;
+}
+
+static u64_t _b_bset64_attacks (const _bench_t * b, u64_t iters)
+{
+  static u32_t moves [2 * _BENCH_MOVES] ;
+  u64_t sink = 0 ;
+
+  (void)b ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += bset64_attacks(_bench_bset64.adj, _bench_own64[it % _BENCH_BOARD_PLAYERS], _bench_ready64, moves, _BENCH_MOVES) ;
+
+  return sink + moves[0] ;
+}
+
+static u64_t _b_bset128_attacks (const _bench_t * b, u64_t iters)
+{
+  static u32_t moves [2 * _BENCH_MOVES] ;
+  u64_t sink = 0 ;
+
+  (void)b ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += bset128_attacks(_bench_bset128.adj, _bench_own128[it % _BENCH_BOARD_PLAYERS], _bench_ready128, moves, _BENCH_MOVES) ;
+
+  return sink + moves[0] ;
+}
+
+static u64_t _b_bset64_income (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  (void)b ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += bset64_income(&_bench_bset64, _bench_own64[it % _BENCH_BOARD_PLAYERS]) ;
+
+  return sink ;
+}
+
+static u64_t _b_bset128_income (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  (void)b ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += bset128_income(&_bench_bset128, _bench_own128[it % _BENCH_BOARD_PLAYERS]) ;
+
+  return sink ;
+}
+
+/* one operation is the features of one player */
+static u64_t _b_board_features (const _bench_t * b, u64_t iters)
+{
+  const board_t * board = &_bench_boards[b->arg] ;
+  f32_t feat [EVAL_FEATURES] ;
+  f32_t sink = 0.0f ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    board_features(board, (u8_t)(it % _BENCH_BOARD_PLAYERS), feat) ;
+    sink += feat[EVAL_BORDER_RATIO] ;
+  }
+
+  return (u64_t)sink ;
+}
+
+static u64_t _b_bset64_features (const _bench_t * b, u64_t iters)
+{
+  const u32_t * armies = _bench_boards[_BENCH_MAP_SMALL].armies ;
+  f32_t feat [EVAL_FEATURES] ;
+  f32_t sink = 0.0f ;
+
+  (void)b ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    bset64_features(&_bench_bset64, _bench_own64[it % _BENCH_BOARD_PLAYERS], armies, feat) ;
+    sink += feat[EVAL_BORDER_RATIO] ;
+  }
+
+  return (u64_t)sink ;
+}
+
+static u64_t _b_bset128_features (const _bench_t * b, u64_t iters)
+{
+  const u32_t * armies = _bench_boards[_BENCH_MAP_MEDIUM].armies ;
+  f32_t feat [EVAL_FEATURES] ;
+  f32_t sink = 0.0f ;
+
+  (void)b ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    bset128_features(&_bench_bset128, _bench_own128[it % _BENCH_BOARD_PLAYERS], armies, feat) ;
+    sink += feat[EVAL_BORDER_RATIO] ;
+  }
+
+  return (u64_t)sink ;
+}
+
+/* ----------------------------------------------------------------
+ * dist
+ */
+
+#define _BENCH_DIST_LAND 64
+
+enum {
+  _BENCH_DIST_42    ,
+  _BENCH_DIST_1000  ,
+  _BENCH_DIST_10000 ,
+  _BENCH_DISTS      ,
+} ;
+
+/* the full matrix of the small and the large board maps, and 64 landmark
+ * rows of a 10000 territories map, whose full matrix would take 100 MB
+ */
+static map_t _bench_dist_map ;
+static const map_t * _bench_dist_maps [_BENCH_DISTS] ;
+static usiz_t _bench_dist_bytes [_BENCH_DISTS] ;
+static dist_t _bench_dists [_BENCH_DISTS] ;
+
+static void _bench_dist_init (void)
+{
+  if (RIGE_NPOS == map_generate(&_bench_dist_map, 10000, 60, (i32v_t){ 400 , 200 }, 7, 1)) {
+    fprintf(stderr, "bench: cannot generate a map of 10000 territories\n") ;
+    exit(1) ;
+  }
+
+  _bench_dist_maps[_BENCH_DIST_42]     = &_bench_maps[_BENCH_MAP_SMALL] ;
+  _bench_dist_maps[_BENCH_DIST_1000]   = &_bench_maps[_BENCH_MAP_LARGE] ;
+  _bench_dist_maps[_BENCH_DIST_10000]  = &_bench_dist_map ;
+  _bench_dist_bytes[_BENCH_DIST_42]    = 42 * 42 ;
+  _bench_dist_bytes[_BENCH_DIST_1000]  = 1000 * 1000 ;
+  _bench_dist_bytes[_BENCH_DIST_10000] = _BENCH_DIST_LAND * 10000 ;
+
+  for (usiz_t d = 0 ; d < _BENCH_DISTS ; ++d) {
+    if (RIGE_NPOS == dist_build(&_bench_dists[d], _bench_dist_maps[d], _bench_dist_bytes[d], 0)) {
+      fprintf(stderr, "bench: cannot build the distances\n") ;
+      exit(1) ;
+    }
+  }
+}
+
+/* one operation is a whole table on every core, `bytes` is its size so
+ * MB/s is the rate it is filled at
+ */
+static u64_t _b_dist_build (const _bench_t * b, u64_t iters)
+{
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    dist_t dist ;
+
+    if (RIGE_NPOS != dist_build(&dist, _bench_dist_maps[b->arg], _bench_dist_bytes[b->arg], 0)) {
+      sink += dist.data[0] ;
+      dist_free(&dist) ;
+    }
+  }
+
+  return sink ;
+}
+
+/* one operation is one query between two territories spread over the map */
+static u64_t _b_dist_get (const _bench_t * b, u64_t iters)
+{
+  const dist_t * dist = &_bench_dists[b->arg] ;
+  u64_t n_terr = dist->n_terr ;
+  u64_t sink = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it)
+    sink += dist_get(dist, (u32_t)((it * 2654435761u) % n_terr), (u32_t)((it * 40503u + 7) % n_terr)) ;
+
+  return sink ;
+}
+
+/* ----------------------------------------------------------------
+ * reorder
+ */
+
+#define _BENCH_WALK_TERR 1000000
+
+enum {
+  _BENCH_WALK_GEN     ,
+  _BENCH_WALK_SHUFFLE ,
+  _BENCH_WALK_RCM     ,
+  _BENCH_WALKS        ,
+} ;
+
+/* the same large map three times: in the order of the generator, which
+ * is already close to a sweep of the layout, with the ids shuffled like
+ * in a map file written by hand, and the shuffled one after
+ * `map_reorder`. every territory has the same armies in all three. the
+ * armies must not fit in the caches, so the maps take seconds to build
+ * and are only built when a `map_walk` case runs
+ */
+static map_t _bench_walk [_BENCH_WALKS] ;
+static u32_t * _bench_walk_armies [_BENCH_WALKS] ;
+
+static void _bench_walk_init (void)
+{
+  map_t * gen = &_bench_walk[_BENCH_WALK_GEN] ;
+  u64_t state = 9 ;
+
+  if (RIGE_NPOS == map_generate(gen, _BENCH_WALK_TERR, 200, (i32v_t){ 5000 , 2500 }, 3, 1)) {
+    fprintf(stderr, "bench: cannot generate a map of %zu territories\n", (size_t)_BENCH_WALK_TERR) ;
+    exit(1) ;
+  }
+
+  usiz_t n_adj = gen->adj_off[_BENCH_WALK_TERR] ;
+  u32_t * perm = (u32_t *)mem_alloc(_BENCH_WALK_TERR * sizeof(u32_t)) ;
+  u32_t * edges = (u32_t *)mem_alloc(n_adj * sizeof(u32_t)) ;
+
+  for (usiz_t w = 0 ; w < _BENCH_WALKS ; ++w)
+    _bench_walk_armies[w] = (u32_t *)mem_alloc(_BENCH_WALK_TERR * sizeof(u32_t)) ;
+
+  if (
+    RIGE_NULL == perm || RIGE_NULL == edges || RIGE_NULL == _bench_walk_armies[_BENCH_WALK_GEN] ||
+    RIGE_NULL == _bench_walk_armies[_BENCH_WALK_SHUFFLE] || RIGE_NULL == _bench_walk_armies[_BENCH_WALK_RCM]
+  ) {
+    fprintf(stderr, "bench: out of memory\n") ;
+    exit(1) ;
+  }
+
+  for (u32_t t = 0 ; t < _BENCH_WALK_TERR ; ++t)
+    perm[t] = t ;
+
+  for (u32_t t = _BENCH_WALK_TERR - 1 ; 0 < t ; --t) {
+    u32_t r = (u32_t)(_bench_rand(&state) % (t + 1)) ;
+    u32_t tmp = perm[t] ;
+
+    perm[t] = perm[r] ;
+    perm[r] = tmp ;
+  }
+
+  /* every border is listed from both sides, keep one */
+  usiz_t n_edges = 0 ;
+
+  for (u32_t t = 0 ; t < _BENCH_WALK_TERR ; ++t) {
+    for (u32_t i = gen->adj_off[t] ; i < gen->adj_off[t + 1] ; ++i) {
+      if (t < gen->adj[i]) {
+        edges[2 * n_edges + 0] = perm[t] ;
+        edges[2 * n_edges + 1] = perm[gen->adj[i]] ;
+        ++n_edges ;
+      }
+    }
+  }
+
+  for (u32_t t = 0 ; t < _BENCH_WALK_TERR ; ++t) {
+    u32_t armies = 1 + (u32_t)(_bench_rand(&state) % 16) ;
+
+    _bench_walk_armies[_BENCH_WALK_GEN][t]           = armies ;
+    _bench_walk_armies[_BENCH_WALK_SHUFFLE][perm[t]] = armies ;
+    _bench_walk_armies[_BENCH_WALK_RCM][perm[t]]     = armies ;
+  }
+
+  if (
+    RIGE_NPOS == map_init(&_bench_walk[_BENCH_WALK_SHUFFLE], _BENCH_WALK_TERR, edges, n_edges) ||
+    RIGE_NPOS == map_init(&_bench_walk[_BENCH_WALK_RCM], _BENCH_WALK_TERR, edges, n_edges) ||
+    RIGE_NPOS == map_reorder(&_bench_walk[_BENCH_WALK_RCM]) ||
+    RIGE_NPOS == map_permute(&_bench_walk[_BENCH_WALK_RCM], _bench_walk_armies[_BENCH_WALK_RCM], sizeof(u32_t))
+  ) {
+    fprintf(stderr, "bench: cannot reorder the map\n") ;
+    exit(1) ;
+  }
+
+  mem_dealloc(perm) ;
+  mem_dealloc(edges) ;
+}
+
+/* the armies around every territory in turn, one operation is one
+ * territory. `arg` is the order
+ */
+static u64_t _b_map_walk (const _bench_t * b, u64_t iters)
+{
+  const map_t * map = &_bench_walk[b->arg] ;
+  const u32_t * armies = _bench_walk_armies[b->arg] ;
+  u64_t sink = 0 ;
+  u32_t t = 0 ;
+
+  for (u64_t it = 0 ; it < iters ; ++it) {
+    for (u32_t i = map->adj_off[t] ; i < map->adj_off[t + 1] ; ++i)
+      sink += armies[map->adj[i]] ;
+
+    t = _BENCH_WALK_TERR == t + 1 ? 0 : t + 1 ;
+  }
+
+  return sink ;
+}
+
+static const _bench_t _benches [] = {
+  { "mem_alloc+dealloc"       , _b_mem_alloc         , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "mem_calloc+dealloc"      , _b_mem_calloc        , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "mem_realloc"             , _b_mem_realloc       , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "mem_copy"                , _b_mem_copy          , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "mem_move"                , _b_mem_move          , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "mem_set"                 , _b_mem_set           , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "mem_comp"                , _b_mem_comp          , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "mem_for_each"            , _b_mem_for_each      , 1 , 0                        , chr_is_ascii     , 0                   } ,
+  { "mem_hash_djb2"           , _b_mem_hash_djb2     , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_size"               , _b_cstr_size         , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_n_size"             , _b_cstr_n_size       , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_copy"               , _b_cstr_copy         , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_n_copy"             , _b_cstr_n_copy       , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_comp"               , _b_cstr_comp         , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_n_comp"             , _b_cstr_n_comp       , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_icomp"              , _b_cstr_icomp        , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_n_icomp"            , _b_cstr_n_icomp      , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_chr"                , _b_cstr_chr          , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_n_chr"              , _b_cstr_n_chr        , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_ichr"               , _b_cstr_ichr         , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_n_ichr"             , _b_cstr_n_ichr       , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_str"                , _b_cstr_str          , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_n_str"              , _b_cstr_n_str        , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_istr"               , _b_cstr_istr         , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_n_istr"             , _b_cstr_n_istr       , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_to_upper"           , _b_cstr_to_upper     , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_n_to_upper"         , _b_cstr_n_to_upper   , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_to_lower"           , _b_cstr_to_lower     , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_n_to_lower"         , _b_cstr_n_to_lower   , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_for_each"           , _b_cstr_for_each     , 1 , 0                        , chr_is_ascii     , 0                   } ,
+  { "cstr_n_for_each"         , _b_cstr_n_for_each   , 1 , 0                        , chr_is_ascii     , 0                   } ,
+  { "cstr_dup"                , _b_cstr_dup          , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_n_dup"              , _b_cstr_n_dup        , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_hash_djb2"          , _b_cstr_hash_djb2    , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "cstr_n_hash_djb2"        , _b_cstr_n_hash_djb2  , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "str_make"                , _b_str_make          , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "str_n_make"              , _b_str_n_make        , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "str_copy"                , _b_str_copy          , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "str_n_copy"              , _b_str_n_copy        , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "str_comp"                , _b_str_comp          , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "str_n_comp"              , _b_str_n_comp        , 1 , 0                        , RIGE_NULL        , 0                   } ,
+  { "chr_is_ascii"            , _b_chr               , 0 , 16 * 256                 , chr_is_ascii     , 0                   } ,
+  { "chr_to_ascii"            , _b_chr               , 0 , 16 * 256                 , chr_to_ascii     , 0                   } ,
+  { "chr_is_ansi"             , _b_chr               , 0 , 16 * 256                 , chr_is_ansi      , 0                   } ,
+  { "chr_to_ansi"             , _b_chr               , 0 , 16 * 256                 , chr_to_ansi      , 0                   } ,
+  { "chr_is_cntrl"            , _b_chr               , 0 , 16 * 256                 , chr_is_cntrl     , 0                   } ,
+  { "chr_is_print"            , _b_chr               , 0 , 16 * 256                 , chr_is_print     , 0                   } ,
+  { "chr_is_space_hor"        , _b_chr               , 0 , 16 * 256                 , chr_is_space_hor , 0                   } ,
+  { "chr_is_space_ver"        , _b_chr               , 0 , 16 * 256                 , chr_is_space_ver , 0                   } ,
+  { "chr_is_space"            , _b_chr               , 0 , 16 * 256                 , chr_is_space     , 0                   } ,
+  { "chr_is_punct"            , _b_chr               , 0 , 16 * 256                 , chr_is_punct     , 0                   } ,
+  { "chr_is_graph"            , _b_chr               , 0 , 16 * 256                 , chr_is_graph     , 0                   } ,
+  { "chr_is_upper"            , _b_chr               , 0 , 16 * 256                 , chr_is_upper     , 0                   } ,
+  { "chr_is_lower"            , _b_chr               , 0 , 16 * 256                 , chr_is_lower     , 0                   } ,
+  { "chr_to_upper"            , _b_chr               , 0 , 16 * 256                 , chr_to_upper     , 0                   } ,
+  { "chr_to_lower"            , _b_chr               , 0 , 16 * 256                 , chr_to_lower     , 0                   } ,
+  { "chr_is_alpha"            , _b_chr               , 0 , 16 * 256                 , chr_is_alpha     , 0                   } ,
+  { "chr_is_digit"            , _b_chr               , 0 , 16 * 256                 , chr_is_digit     , 0                   } ,
+  { "chr_is_digit_bin"        , _b_chr               , 0 , 16 * 256                 , chr_is_digit_bin , 0                   } ,
+  { "chr_is_digit_oct"        , _b_chr               , 0 , 16 * 256                 , chr_is_digit_oct , 0                   } ,
+  { "chr_is_digit_hex"        , _b_chr               , 0 , 16 * 256                 , chr_is_digit_hex , 0                   } ,
+  { "chr_is_alnum"            , _b_chr               , 0 , 16 * 256                 , chr_is_alnum     , 0                   } ,
+  { "chr_to_digit"            , _b_chr_to_digit      , 0 , 16 * 256                 , RIGE_NULL        , 0                   } ,
+  { "utf8_decode/ascii"       , _b_utf8_decode       , 0 , _BENCH_UTF8_SIZE         , RIGE_NULL        , _BENCH_UTF8_ASCII   } ,
+  { "utf8_decode/mixed"       , _b_utf8_decode       , 0 , _BENCH_UTF8_SIZE         , RIGE_NULL        , _BENCH_UTF8_MIXED   } ,
+  { "utf8_encode/mixed"       , _b_utf8_encode       , 0 , _BENCH_UTF8_SIZE         , RIGE_NULL        , _BENCH_UTF8_MIXED   } ,
+  { "utf8_valid/ascii"        , _b_utf8_valid        , 0 , _BENCH_UTF8_SIZE         , RIGE_NULL        , _BENCH_UTF8_ASCII   } ,
+  { "utf8_valid/mixed"        , _b_utf8_valid        , 0 , _BENCH_UTF8_SIZE         , RIGE_NULL        , _BENCH_UTF8_MIXED   } ,
+  { "ref_utf8_valid/ascii"    , _b_ref_utf8_valid    , 0 , _BENCH_UTF8_SIZE         , RIGE_NULL        , _BENCH_UTF8_ASCII   } ,
+  { "ref_utf8_valid/mixed"    , _b_ref_utf8_valid    , 0 , _BENCH_UTF8_SIZE         , RIGE_NULL        , _BENCH_UTF8_MIXED   } ,
+  { "utf8_count/ascii"        , _b_utf8_count        , 0 , _BENCH_UTF8_SIZE         , RIGE_NULL        , _BENCH_UTF8_ASCII   } ,
+  { "utf8_count/mixed"        , _b_utf8_count        , 0 , _BENCH_UTF8_SIZE         , RIGE_NULL        , _BENCH_UTF8_MIXED   } ,
+  { "ref_utf8_count/ascii"    , _b_ref_utf8_count    , 0 , _BENCH_UTF8_SIZE         , RIGE_NULL        , _BENCH_UTF8_ASCII   } ,
+  { "ref_utf8_count/mixed"    , _b_ref_utf8_count    , 0 , _BENCH_UTF8_SIZE         , RIGE_NULL        , _BENCH_UTF8_MIXED   } ,
+  { "utf8_width/ascii"        , _b_utf8_width        , 0 , _BENCH_UTF8_SIZE         , RIGE_NULL        , _BENCH_UTF8_ASCII   } ,
+  { "utf8_width/mixed"        , _b_utf8_width        , 0 , _BENCH_UTF8_SIZE         , RIGE_NULL        , _BENCH_UTF8_MIXED   } ,
+  { "utf8_find_cntrl/ascii"   , _b_utf8_find_cntrl   , 0 , _BENCH_UTF8_SIZE         , RIGE_NULL        , _BENCH_UTF8_ASCII   } ,
+  { "utf8_find_cntrl/mixed"   , _b_utf8_find_cntrl   , 0 , _BENCH_UTF8_SIZE         , RIGE_NULL        , _BENCH_UTF8_MIXED   } ,
+  { "num_parse_u64/dec"       , _b_num_parse_u64     , 0 , 0                        , RIGE_NULL        , _BENCH_NUM_DEC      } ,
+  { "strtoull/dec"            , _b_strtoull          , 0 , 0                        , RIGE_NULL        , _BENCH_NUM_DEC      } ,
+  { "num_parse_u64/hex"       , _b_num_parse_u64     , 0 , 0                        , RIGE_NULL        , _BENCH_NUM_HEX      } ,
+  { "strtoull/hex"            , _b_strtoull          , 0 , 0                        , RIGE_NULL        , _BENCH_NUM_HEX      } ,
+  { "num_parse_i64/dec"       , _b_num_parse_i64     , 0 , 0                        , RIGE_NULL        , _BENCH_NUM_NEG      } ,
+  { "strtoll/dec"             , _b_strtoll           , 0 , 0                        , RIGE_NULL        , _BENCH_NUM_NEG      } ,
+  { "num_fmt_u64/dec"         , _b_num_fmt_u64       , 0 , 0                        , RIGE_NULL        , _BENCH_NUM_DEC      } ,
+  { "snprintf_u64/dec"        , _b_snprintf_u64      , 0 , 0                        , RIGE_NULL        , _BENCH_NUM_DEC      } ,
+  { "num_fmt_u64/hex"         , _b_num_fmt_u64       , 0 , 0                        , RIGE_NULL        , _BENCH_NUM_HEX      } ,
+  { "snprintf_u64/hex"        , _b_snprintf_u64      , 0 , 0                        , RIGE_NULL        , _BENCH_NUM_HEX      } ,
+  { "num_fmt_i64/dec"         , _b_num_fmt_i64       , 0 , 0                        , RIGE_NULL        , _BENCH_NUM_NEG      } ,
+  { "snprintf_i64/dec"        , _b_snprintf_i64      , 0 , 0                        , RIGE_NULL        , _BENCH_NUM_NEG      } ,
+  { "str_copy_append/16k"     , _b_str_append        , 0 , 16 * _BENCH_KB           , RIGE_NULL        , 16 * _BENCH_KB      } ,
+  { "strbuf/16k"              , _b_strbuf            , 0 , 16 * _BENCH_KB           , RIGE_NULL        , 16 * _BENCH_KB      } ,
+  { "strbuf/1m"               , _b_strbuf            , 0 , 1024 * _BENCH_KB         , RIGE_NULL        , 1024 * _BENCH_KB    } ,
+  { "strbuf_arena/1m"         , _b_strbuf_arena      , 0 , 1024 * _BENCH_KB         , RIGE_NULL        , 1024 * _BENCH_KB    } ,
+  { "chan_spsc/1p"            , _b_chan              , 0 , 0                        , RIGE_NULL        , 1                   } ,
+  { "mutex_queue/1p"          , _b_queue             , 0 , 0                        , RIGE_NULL        , 1                   } ,
+  { "chan_mpsc/4p"            , _b_chan              , 0 , 0                        , RIGE_NULL        , 4                   } ,
+  { "mutex_queue/4p"          , _b_queue             , 0 , 0                        , RIGE_NULL        , 4                   } ,
+  { "chan_pingpong"           , _b_chan_pingpong     , 0 , 0                        , RIGE_NULL        , 0                   } ,
+  { "mutex_pingpong"          , _b_queue_pingpong    , 0 , 0                        , RIGE_NULL        , 0                   } ,
+  { "eval_one"                , _b_eval_one          , 0 , 0                        , RIGE_NULL        , 0                   } ,
+  { "eval_run/8"              , _b_eval_run          , 0 , 0                        , RIGE_NULL        , 8                   } ,
+  { "eval_run/64"             , _b_eval_run          , 0 , 0                        , RIGE_NULL        , EVAL_BATCH          } ,
+  { "board_income/42"         , _b_board_income      , 0 , 0                        , RIGE_NULL        , _BENCH_MAP_SMALL    } ,
+  { "board_income_scan/42"    , _b_board_income_scan , 0 , 0                        , RIGE_NULL        , _BENCH_MAP_SMALL    } ,
+  { "board_income/1000"       , _b_board_income      , 0 , 0                        , RIGE_NULL        , _BENCH_MAP_LARGE    } ,
+  { "board_income_scan/1000"  , _b_board_income_scan , 0 , 0                        , RIGE_NULL        , _BENCH_MAP_LARGE    } ,
+  { "board_set_owner/42"      , _b_board_set_owner   , 0 , 0                        , RIGE_NULL        , _BENCH_MAP_SMALL    } ,
+  { "board_set_owner/1000"    , _b_board_set_owner   , 0 , 0                        , RIGE_NULL        , _BENCH_MAP_LARGE    } ,
+  { "map_attacks/42"          , _b_map_attacks       , 0 , 0                        , RIGE_NULL        , _BENCH_MAP_SMALL    } ,
+  { "bset64_attacks/42"       , _b_bset64_attacks    , 0 , 0                        , RIGE_NULL        , 0                   } ,
+  { "map_attacks/120"         , _b_map_attacks       , 0 , 0                        , RIGE_NULL        , _BENCH_MAP_MEDIUM   } ,
+  { "bset128_attacks/120"     , _b_bset128_attacks   , 0 , 0                        , RIGE_NULL        , 0                   } ,
+  { "map_attacks/1000"        , _b_map_attacks       , 0 , 0                        , RIGE_NULL        , _BENCH_MAP_LARGE    } ,
+  { "bset64_income/42"        , _b_bset64_income     , 0 , 0                        , RIGE_NULL        , 0                   } ,
+  { "board_income_scan/120"   , _b_board_income_scan , 0 , 0                        , RIGE_NULL        , _BENCH_MAP_MEDIUM   } ,
+  { "bset128_income/120"      , _b_bset128_income    , 0 , 0                        , RIGE_NULL        , 0                   } ,
+  { "board_features/42"       , _b_board_features    , 0 , 0                        , RIGE_NULL        , _BENCH_MAP_SMALL    } ,
+  { "bset64_features/42"      , _b_bset64_features   , 0 , 0                        , RIGE_NULL        , 0                   } ,
+  { "board_features/120"      , _b_board_features    , 0 , 0                        , RIGE_NULL        , _BENCH_MAP_MEDIUM   } ,
+  { "bset128_features/120"    , _b_bset128_features  , 0 , 0                        , RIGE_NULL        , 0                   } ,
+  { "board_features/1000"     , _b_board_features    , 0 , 0                        , RIGE_NULL        , _BENCH_MAP_LARGE    } ,
+  { "dist_build/42"           , _b_dist_build        , 0 , 42 * 42                  , RIGE_NULL        , _BENCH_DIST_42      } ,
+  { "dist_build/1000"         , _b_dist_build        , 0 , 1000 * 1000              , RIGE_NULL        , _BENCH_DIST_1000    } ,
+  { "dist_build/10000/land64" , _b_dist_build        , 0 , _BENCH_DIST_LAND * 10000 , RIGE_NULL        , _BENCH_DIST_10000   } ,
+  { "dist_get/42"             , _b_dist_get          , 0 , 0                        , RIGE_NULL        , _BENCH_DIST_42      } ,
+  { "dist_get/1000"           , _b_dist_get          , 0 , 0                        , RIGE_NULL        , _BENCH_DIST_1000    } ,
+  { "dist_get/10000/land64"   , _b_dist_get          , 0 , 0                        , RIGE_NULL        , _BENCH_DIST_10000   } ,
+  { "map_walk/gen"            , _b_map_walk          , 0 , 0                        , RIGE_NULL        , _BENCH_WALK_GEN     } ,
+  { "map_walk/shuffled"       , _b_map_walk          , 0 , 0                        , RIGE_NULL        , _BENCH_WALK_SHUFFLE } ,
+  { "map_walk/rcm"            , _b_map_walk          , 0 , 0                        , RIGE_NULL        , _BENCH_WALK_RCM     } ,
+} ;
+
+/* ----------------------------------------------------------------
+ * harness
+ */
+
+#define _BENCH_MAX_TRIALS 1000
+#define _BENCH_MAX_BASE   4096
+
+enum {
+  _BENCH_TEXT ,
+  _BENCH_CSV  ,
+  _BENCH_JSON
+} ;
+
+typedef struct _bench_res_s _bench_res_t ;
+
+struct _bench_res_s {
+  const char * name   ;
+  chr_t        size [16] ;
+  u64_t        iters  ;
+  f64_t        median ;
+  f64_t        p10    ;
+  f64_t        p90    ;
+  f64_t        mb_s   ;
+} ;
+
+typedef struct _bench_base_s _bench_base_t ;
+
+/* one line of a baseline csv */
+struct _bench_base_s {
+  chr_t name [64] ;
+  chr_t size [16] ;
+  f64_t median    ;
+} ;
+
+static u64_t _bench_now (void)
+{
+  struct timespec ts ;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts) ;
+
+  return (u64_t)ts.tv_sec * 1000000000 + ts.tv_nsec ;
+}
+
+static int _bench_comp_f64 (const void * lhs, const void * rhs)
+{
+  f64_t a = *(const f64_t *)lhs ;
+  f64_t b = *(const f64_t *)rhs ;
+
+  return (a > b) - (a < b) ;
+}
+
+/* nearest rank, `trial` is sorted */
+static f64_t _bench_pct (const f64_t * trial, usiz_t n, usiz_t pct)
+{
+  usiz_t rank = (pct * n + 99) / 100 ;
+
+  return trial[0 == rank ? 0 : rank - 1] ;
+}
+
+static void _bench_run (const _bench_t * b, usiz_t bytes, usiz_t warmup, usiz_t trials, u64_t time_ns, _bench_res_t * res)
+{
+  static f64_t trial [_BENCH_MAX_TRIALS] ;
+  u64_t iters = 1 ;
+
+  /* double the iterations until a trial is long enough to time */
+  for (;;) {
+    u64_t start = _bench_now() ;
+
+    _bench_sink += b->run(b, iters) ;
+
+    if (time_ns <= _bench_now() - start || (1ULL << 40) <= iters)
+      break ;
+
+    iters *= 2 ;
+  }
+
+  for (usiz_t w = 0 ; w < warmup ; ++w)
+    _bench_sink += b->run(b, iters) ;
+
+  for (usiz_t t = 0 ; t < trials ; ++t) {
+    u64_t start = _bench_now() ;
+
+    _bench_sink += b->run(b, iters) ;
+    trial[t] = (f64_t)(_bench_now() - start) / iters ;
+  }
+
+  qsort(trial, trials, sizeof(f64_t), _bench_comp_f64) ;
+
+  res->name   = b->name ;
+  res->iters  = iters ;
+  res->median = _bench_pct(trial, trials, 50) ;
+  res->p10    = _bench_pct(trial, trials, 10) ;
+  res->p90    = _bench_pct(trial, trials, 90) ;
+  res->mb_s   = 0 == bytes ? 0.0 : bytes * 1e3 / res->median ;
+}
+
+static usiz_t _bench_load_base (const cstr_t path, _bench_base_t * base)
+{
+  FILE * file = fopen(path, "r") ;
+
+  if (RIGE_NULL == file)
+    return RIGE_NPOS ;
+
+  chr_t line [256] ;
+  usiz_t n = 0 ;
+
+  /* the first line is the header */
+  while (n < _BENCH_MAX_BASE && RIGE_NULL != fgets(line, sizeof(line), file)) {
+    usiz_t name = cstr_chr(line, ',') ;
+
+    if (RIGE_NPOS == name || sizeof(base[n].name) <= name)
+      continue ;
+
+    usiz_t size = cstr_chr(line + name + 1, ',') ;
+
+    if (RIGE_NPOS == size || sizeof(base[n].size) <= size || 0 == cstr_n_comp(line, "name,", 5))
+      continue ;
+
+    cstr_n_copy(base[n].name, line, name) ;
+    base[n].name[name] = 0 ;
+    cstr_n_copy(base[n].size, line + name + 1, size) ;
+    base[n].size[size] = 0 ;
+
+    /* `iters` comes next, then the median */
+    chr_t * ptr = line + name + 1 + size + 1 ;
+    usiz_t skip = cstr_chr(ptr, ',') ;
+
+    if (RIGE_NPOS == skip)
+      continue ;
+
+    base[n].median = strtod(ptr + skip + 1, RIGE_NULL) ;
+    ++n ;
+  }
+
+  fclose(file) ;
+
+  return n ;
+}
+
+static void _bench_print (const _bench_res_t * res, i32_t format, usiz_t first)
+{
+  switch (format) {
+    case _BENCH_CSV :
+      printf("%s,%s,%llu,%.3f,%.3f,%.3f,%.3f\n", res->name, res->size, (unsigned long long)res->iters, res->median, res->p10, res->p90, res->mb_s) ;
+      break ;
+
+    case _BENCH_JSON :
+      printf(
+        "%s  { \"name\": \"%s\", \"size\": \"%s\", \"iters\": %llu, \"median_ns\": %.3f, \"p10_ns\": %.3f, \"p90_ns\": %.3f, \"mb_s\": %.3f }",
+        0 != first ? "" : ",\n", res->name, res->size, (unsigned long long)res->iters, res->median, res->p10, res->p90, res->mb_s
+      ) ;
+      break ;
+
+    default :
+      printf("%-24s %6s %12llu %14.2f %14.2f %14.2f %12.1f\n", res->name, res->size, (unsigned long long)res->iters, res->median, res->p10, res->p90, res->mb_s) ;
+      break ;
+  }
+
+  fflush(stdout) ;
+}
+
+static usiz_t _bench_arg_num (i32_t argc, char ** argv, i32_t * i, usiz_t * val)
+{
+  chr_t * end ;
+
+  if (argc <= *i + 1 || 0 == chr_is_digit(argv[*i + 1][0]))
+    return RIGE_NPOS ;
+
+  u64_t num = strtoull(argv[*i + 1], &end, 10) ;
+
+  if (0 != *end)
+    return RIGE_NPOS ;
+
+  ++*i ;
+  *val = num ;
+
+  return num ;
+}
+
+int main (int argc, char ** argv)
+{
+  static _bench_base_t base [_BENCH_MAX_BASE] ;
+
+  i32_t format = _BENCH_TEXT ;
+  const char * filter = RIGE_NULL ;
+  const char * compare = RIGE_NULL ;
+  usiz_t trials = 11 ;
+  usiz_t warmup = 2 ;
+  usiz_t time_us = 2000 ;
+  usiz_t threshold = 10 ;
+  usiz_t n_base = 0 ;
+
+  _bench_utf8_init() ;
+  _bench_num_init() ;
+  _bench_eval_init() ;
+  _bench_board_init() ;
+  _bench_bset_init() ;
+  _bench_dist_init() ;
+
+  for (i32_t i = 1 ; i < argc ; ++i) {
+    usiz_t ok = 1 ;
+
+    if (0 == cstr_comp(argv[i], "--format") && i + 1 < argc) {
+      ++i ;
+      format = 0 == cstr_comp(argv[i], "csv") ? _BENCH_CSV : 0 == cstr_comp(argv[i], "json") ? _BENCH_JSON : _BENCH_TEXT ;
+    } else if (0 == cstr_comp(argv[i], "--filter") && i + 1 < argc) {
+      filter = argv[++i] ;
+    } else if (0 == cstr_comp(argv[i], "--compare") && i + 1 < argc) {
+      compare = argv[++i] ;
+    } else if (0 == cstr_comp(argv[i], "--trials")) {
+      ok = RIGE_NPOS != _bench_arg_num(argc, argv, &i, &trials) && 0 < trials && trials <= _BENCH_MAX_TRIALS ;
+    } else if (0 == cstr_comp(argv[i], "--warmup")) {
+      ok = RIGE_NPOS != _bench_arg_num(argc, argv, &i, &warmup) ;
+    } else if (0 == cstr_comp(argv[i], "--time-us")) {
+      ok = RIGE_NPOS != _bench_arg_num(argc, argv, &i, &time_us) ;
+    } else if (0 == cstr_comp(argv[i], "--threshold")) {
+      ok = RIGE_NPOS != _bench_arg_num(argc, argv, &i, &threshold) ;
+    } else {
+      ok = 0 ;
+    }
+
+    if (0 == ok) {
+      fprintf(stderr, "usage: %s [--format text|csv|json] [--filter <substring>] [--trials <n>] [--warmup <n>] [--time-us <us>] [--compare <baseline.csv>] [--threshold <percent>]\n", argv[0]) ;
+      return 2 ;
+    }
+  }
+
+  if (RIGE_NULL != compare) {
+    n_base = _bench_load_base((cstr_t)compare, base) ;
+
+    if (RIGE_NPOS == n_base) {
+      fprintf(stderr, "%s: cannot read %s\n", argv[0], compare) ;
+      return 2 ;
+    }
+
+    /* the comparison is the report */
+    format = _BENCH_TEXT ;
+    printf("%-24s %6s %14s %14s %9s\n", "name", "size", "base ns", "median ns", "change") ;
+  } else if (_BENCH_CSV == format) {
+    printf("name,size,iters,median_ns,p10_ns,p90_ns,mb_s\n") ;
+  } else if (_BENCH_JSON == format) {
+    printf("[\n") ;
+  } else {
+    printf("%-24s %6s %12s %14s %14s %14s %12s\n", "name", "size", "iters", "median ns", "p10 ns", "p90 ns", "MB/s") ;
+  }
+
+  usiz_t n_slower = 0 ;
+  usiz_t first = 1 ;
+  usiz_t corpus = RIGE_NPOS ;
+
+  /* sized cases are grouped by size, the corpus is built once per size */
+  for (usiz_t s = 0 ; s <= sizeof(_bench_sizes) / sizeof(_bench_sizes[0]) ; ++s) {
+    i32_t sized = s < sizeof(_bench_sizes) / sizeof(_bench_sizes[0]) ;
+
+    for (usiz_t k = 0 ; k < sizeof(_benches) / sizeof(_benches[0]) ; ++k) {
+      const _bench_t * b = &_benches[k] ;
+      _bench_res_t res ;
+
+      if (sized != b->sized || (RIGE_NULL != filter && RIGE_NPOS == cstr_str((cstr_t)b->name, (cstr_t)filter)))
+        continue ;
+
+      if (_b_map_walk == b->run && RIGE_NULL == _bench_walk_armies[0]) {
+        _bench_walk_init() ;
+      }
+
+      usiz_t bytes = b->bytes ;
+
+      if (0 != sized) {
+        if (corpus != _bench_sizes[s]) {
+          if (RIGE_NPOS == _bench_corpus_init(_bench_sizes[s])) {
+            fprintf(stderr, "%s: out of memory\n", argv[0]) ;
+            return 2 ;
+          }
+
+          corpus = _bench_sizes[s] ;
+        }
+
+        bytes = _corpus.bytes / _corpus.n ;
+        snprintf(res.size, sizeof(res.size), 0 == _bench_sizes[s] ? "mix" : "%zu", (size_t)_bench_sizes[s]) ;
+      } else {
+        snprintf(res.size, sizeof(res.size), "-") ;
+      }
+
+      _bench_run(b, bytes, warmup, trials, (u64_t)time_us * 1000, &res) ;
+
+      if (RIGE_NULL == compare) {
+        _bench_print(&res, format, first) ;
+        first = 0 ;
+        continue ;
+      }
+
+      usiz_t j ;
+
+      for (j = 0 ; j < n_base ; ++j) {
+        if (0 == cstr_comp(base[j].name, (cstr_t)res.name) && 0 == cstr_comp(base[j].size, res.size))
+          break ;
+      }
+
+      if (n_base == j) {
+        printf("%-24s %6s %14s %14.2f %9s\n", res.name, res.size, "-", res.median, "new") ;
+        continue ;
+      }
+
+      f64_t change = 100.0 * (res.median - base[j].median) / base[j].median ;
+      i32_t slower = (f64_t)threshold < change ;
+
+      n_slower += slower ;
+      printf("%-24s %6s %14.2f %14.2f %+8.1f%%%s\n", res.name, res.size, base[j].median, res.median, change, 0 != slower ? "  REGRESSION" : "") ;
+    }
+  }
+
+  _bench_corpus_free() ;
+
+  if (_BENCH_JSON == format && RIGE_NULL == compare) {
+    printf("\n]\n") ;
+  }
+
+  if (RIGE_NULL != compare) {
+    printf("%zu case(s) slower than the baseline by more than %zu%%\n", (size_t)n_slower, (size_t)threshold) ;
+  }
+
+  return 0 == n_slower ? 0 : 1 ;
+}
@@ -1,5 +1,225 @@
+#define _DEFAULT_SOURCE
+
 #include "rige.h"
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* ----------------------------------------------------------------
+ * prof
+ */
+
+#ifdef _RIGE_HAS_PROF
+
+#include <time.h>
+
+#define _PROF_EVENTS 4096
+
+typedef struct _prof_event_s _prof_event_t ;
+typedef struct _prof_block_s _prof_block_t ;
+
+struct _prof_event_s {
+  i32_t id    ;
+  u64_t start ;
+  u64_t stop  ;
+} ;
+
+/* one block per thread, so probes never touch shared cache lines */
+struct _prof_block_s {
+  _prof_block_t * next ;
+  u64_t           tid  ;
+  u64_t           calls [PROF_COUNT] ;
+  u64_t           bytes [PROF_COUNT] ;
+  u64_t           nsecs [PROF_COUNT] ;
+  usiz_t          n_events ;
+  _prof_event_t   events [_PROF_EVENTS] ;
+} ;
+
+static const char * _prof_names [PROF_COUNT] = {
+  "mem_alloc"   ,
+  "mem_realloc" ,
+  "mem_dealloc" ,
+  "movegen"     ,
+  "battle"      ,
+  "render"      ,
+  "io"
+} ;
+
+static pthread_mutex_t _prof_lock = PTHREAD_MUTEX_INITIALIZER ;
+static _prof_block_t * _prof_head = RIGE_NULL ;
+static u64_t           _prof_tids = 0 ;
+static u64_t           _prof_base = 0 ;
+static char *          _prof_path = RIGE_NULL ;
+
+static _Thread_local _prof_block_t * _prof_self = RIGE_NULL ;
+
+static _prof_block_t * _prof_get (void)
+{
+  if (RIGE_NULL != _prof_self)
+    return _prof_self ;
+
+  /* do not use `mem_calloc` here, it would call back into the probes */
+  _prof_block_t * block = (_prof_block_t *)calloc(1, sizeof(_prof_block_t)) ;
+
+  if (RIGE_NULL == block)
+    return RIGE_NULL ;
+
+  /* blocks are never freed, the counters have to outlive their thread */
+  pthread_mutex_lock(&_prof_lock) ;
+  block->tid  = _prof_tids++ ;
+  block->next = _prof_head ;
+  _prof_head  = block ;
+  pthread_mutex_unlock(&_prof_lock) ;
+
+  _prof_self = block ;
+
+  return block ;
+}
+
+_RIGE_API u64_t prof_now (void)
+{
+  struct timespec ts ;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts) ;
+
+  return (u64_t)ts.tv_sec * 1000000000 + (u64_t)ts.tv_nsec ;
+}
+
+_RIGE_API void prof_count (i32_t id, u64_t bytes)
+{
+  _prof_block_t * block = _prof_get() ;
+
+  if (RIGE_NULL == block || id < 0 || PROF_COUNT <= id)
+    return ;
+
+  ++block->calls[id] ;
+  block->bytes[id] += bytes ;
+}
+
+_RIGE_API void prof_time (i32_t id, u64_t start, u64_t stop)
+{
+  _prof_block_t * block = _prof_get() ;
+
+  if (RIGE_NULL == block || id < 0 || PROF_COUNT <= id)
+    return ;
+
+  ++block->calls[id] ;
+  block->nsecs[id] += stop - start ;
+
+  /* keep the first events only, the summary still sees all of them */
+  if (block->n_events < _PROF_EVENTS) {
+    _prof_event_t * event = &block->events[block->n_events++] ;
+
+    event->id    = id ;
+    event->start = start ;
+    event->stop  = stop ;
+  }
+}
+
+_RIGE_API void prof_dump (FILE * file)
+{
+  u64_t calls [PROF_COUNT] = { 0 } ;
+  u64_t bytes [PROF_COUNT] = { 0 } ;
+  u64_t nsecs [PROF_COUNT] = { 0 } ;
+
+  pthread_mutex_lock(&_prof_lock) ;
+
+  for (_prof_block_t * block = _prof_head ; RIGE_NULL != block ; block = block->next) {
+    for (i32_t id = 0 ; id < PROF_COUNT ; ++id) {
+      calls[id] += block->calls[id] ;
+      bytes[id] += block->bytes[id] ;
+      nsecs[id] += block->nsecs[id] ;
+    }
+  }
+
+  pthread_mutex_unlock(&_prof_lock) ;
+
+  fprintf(file, "%-12s %12s %14s %14s %10s\n", "probe", "calls", "bytes", "total [ns]", "avg [ns]") ;
+
+  for (i32_t id = 0 ; id < PROF_COUNT ; ++id) {
+    if (0 == calls[id])
+      continue ;
+
+    fprintf(
+      file, "%-12s %12llu %14llu %14llu %10llu\n",
+      _prof_names[id],
+      (unsigned long long)calls[id],
+      (unsigned long long)bytes[id],
+      (unsigned long long)nsecs[id],
+      (unsigned long long)(nsecs[id] / calls[id])
+    ) ;
+  }
+}
+
+_RIGE_API void prof_dump_trace (FILE * file)
+{
+  /* chrome trace event format, load it in `chrome://tracing` */
+  i32_t first = 1 ;
+
+  fprintf(file, "{\"traceEvents\":[\n") ;
+
+  pthread_mutex_lock(&_prof_lock) ;
+
+  for (_prof_block_t * block = _prof_head ; RIGE_NULL != block ; block = block->next) {
+    for (usiz_t i = 0 ; i < block->n_events ; ++i) {
+      _prof_event_t * event = &block->events[i] ;
+
+      fprintf(
+        file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f}",
+        first ? "" : ",\n",
+        _prof_names[event->id],
+        (unsigned long long)block->tid,
+        (i64_t)(event->start - _prof_base) / 1000.0,
+        (event->stop - event->start) / 1000.0
+      ) ;
+
+      first = 0 ;
+    }
+  }
+
+  pthread_mutex_unlock(&_prof_lock) ;
+
+  fprintf(file, "\n]}\n") ;
+}
+
+static void _prof_exit (void)
+{
+  prof_dump(stderr) ;
+
+  if (RIGE_NULL != _prof_path) {
+    FILE * file = fopen(_prof_path, "w") ;
+
+    if (RIGE_NULL != file) {
+      prof_dump_trace(file) ;
+      fclose(file) ;
+    }
+
+    free(_prof_path) ;
+    _prof_path = RIGE_NULL ;
+  }
+}
+
+_RIGE_API void prof_at_exit (const char * trace_path)
+{
+  _prof_base = prof_now() ;
+
+  if (RIGE_NULL != trace_path) {
+    usiz_t size = cstr_size((cstr_t)trace_path) + 1 ;
+
+    _prof_path = (char *)malloc(size) ;
+
+    if (RIGE_NULL != _prof_path) {
+      mem_copy(_prof_path, (ptr_t)trace_path, size) ;
+    }
+  }
+
+  atexit(_prof_exit) ;
+}
+
+#undef _PROF_EVENTS
+
+#endif
 
 /* ----------------------------------------------------------------
  * mem
@@ -10,6 +230,8 @@ _RIGE_API ptr_t mem_alloc (usiz_t size)
   if (0 == size)
     return RIGE_NULL ;
 
+  RIGE_PROF_COUNT(PROF_MEM_ALLOC, size) ;
+
   /* maybe later a platform-specific implementation */
   return malloc(size) ;
 }
@@ -19,6 +241,8 @@ _RIGE_API ptr_t mem_calloc (usiz_t n, usiz_t size)
   if (0 == n || 0 == size)
     return RIGE_NULL ;
 
+  RIGE_PROF_COUNT(PROF_MEM_ALLOC, n * size) ;
+
   /* maybe later a platform-specific implementation */
   return calloc(n, size) ;
 }
@@ -27,14 +251,19 @@ _RIGE_API ptr_t mem_realloc (ptr_t ptr, usiz_t size)
 {
   if (0 == size) {
     if (RIGE_NULL != ptr) {
+      RIGE_PROF_COUNT(PROF_MEM_DEALLOC, 0) ;
       free(ptr) ;
     }
 
     return RIGE_NULL ;
   }
 
-  if (RIGE_NULL == ptr)
+  if (RIGE_NULL == ptr) {
+    RIGE_PROF_COUNT(PROF_MEM_ALLOC, size) ;
     return malloc(size) ;
+  }
+
+  RIGE_PROF_COUNT(PROF_MEM_REALLOC, size) ;
 
   /* maybe later a platform-specific implementation */
   return realloc(ptr, size) ;
@@ -43,6 +272,8 @@ _RIGE_API ptr_t mem_realloc (ptr_t ptr, usiz_t size)
 _RIGE_API void mem_dealloc (ptr_t ptr)
 {
   if (RIGE_NULL != ptr) {
+    RIGE_PROF_COUNT(PROF_MEM_DEALLOC, 0) ;
+
     /* maybe later a platform-specific implementation */
     free(ptr) ;
   }
@@ -128,6 +359,10 @@ _RIGE_API i32_t mem_comp (const ptr_t _lhs, const ptr_t _rhs, usiz_t n)
   for (size = 0 ; size < n && lhs[size] == rhs[size] ; ++size)
     /* continue */ ;
 
+  /* do not look past the `n` bytes we were asked to compare */
+  if (size == n)
+    return 0 ;
+
   return (i32_t)lhs[size] - (i32_t)rhs[size] ;
 }
 
@@ -197,8 +432,32 @@ i32_t _chr_tab [] = {
   /* 7. */ 0x00A2 , 0x00A2 , 0x00A2 , 0x00A2 , 0x00A2 , 0x00A2 , 0x00A2 , 0x00A2 , 0x00A2 , 0x00A2 , 0x00A2 , 0x0032 , 0x0032 , 0x0032 , 0x0032 , 0x0001   /* 7. */
 } ;
 
+/* value of every byte as a digit, 0xFF if it is not a digit in any base */
+const u8_t _chr_digit_tab [] = {
+  /*          .0     .1     .2     .3     .4     .5     .6     .7     .8     .9     .A     .B     .C     .D     .E     .F        */
+  /* 0. */ 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , /* 0. */
+  /* 1. */ 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , /* 1. */
+  /* 2. */ 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , /* 2. */
+  /* 3. */ 0x00 , 0x01 , 0x02 , 0x03 , 0x04 , 0x05 , 0x06 , 0x07 , 0x08 , 0x09 , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , /* 3. */
+  /* 4. */ 0xFF , 0x0A , 0x0B , 0x0C , 0x0D , 0x0E , 0x0F , 0x10 , 0x11 , 0x12 , 0x13 , 0x14 , 0x15 , 0x16 , 0x17 , 0x18 , /* 4. */
+  /* 5. */ 0x19 , 0x1A , 0x1B , 0x1C , 0x1D , 0x1E , 0x1F , 0x20 , 0x21 , 0x22 , 0x23 , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , /* 5. */
+  /* 6. */ 0xFF , 0x0A , 0x0B , 0x0C , 0x0D , 0x0E , 0x0F , 0x10 , 0x11 , 0x12 , 0x13 , 0x14 , 0x15 , 0x16 , 0x17 , 0x18 , /* 6. */
+  /* 7. */ 0x19 , 0x1A , 0x1B , 0x1C , 0x1D , 0x1E , 0x1F , 0x20 , 0x21 , 0x22 , 0x23 , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , /* 7. */
+  /* 8. */ 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , /* 8. */
+  /* 9. */ 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , /* 9. */
+  /* A. */ 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , /* A. */
+  /* B. */ 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , /* B. */
+  /* C. */ 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , /* C. */
+  /* D. */ 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , /* D. */
+  /* E. */ 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , /* E. */
+  /* F. */ 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF , 0xFF   /* F. */
+} ;
+
+/* bytes outside 7-bit ASCII have no properties, use the `utf8_*`
+ * functions to classify them
+ */
 #define _verify_prop(chr, prop)     \
-  (_chr_tab[(chr) & 0x7F] & (prop))
+  (0 == ((chr) >> 7) && (_chr_tab[(chr) & 0x7F] & (prop)))
 
 _RIGE_API i32_t chr_is_ascii (i32_t chr)
 {
@@ -311,29 +570,22 @@ _RIGE_API i32_t chr_is_alnum (i32_t chr)
 
 _RIGE_API i32_t chr_to_digit (i32_t chr, i32_t base)
 {
-  chr_t digits_upper [] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ" ;
-  chr_t digits_lower [] = "0123456789abcdefghijklmnopqrstuvwxyz" ;
-
-  usiz_t digit ;
-
-  if (0 == base) {
-    digit = cstr_chr(digits_upper, chr) ;
-
-    if (sizeof(digits_upper) <= digit) {
-      digit = cstr_chr(digits_lower /* could be `+ 10` a better choice? */, chr) ;
+  if (0 != (chr >> 8))
+    return -1 ;
 
-      if (sizeof(digits_lower) <= digit)
-        return -1 ;
-    }
-  } else if (0 < base) {
-    digit = cstr_chr(digits_upper, chr) ;
+  /* `base` > 0 accepts upper case letters only, `base` < 0 lower case
+   * letters only and `base` == 0 both, up to base 36
+   */
+  i32_t digit = _chr_digit_tab[chr] ;
 
-    if (base <= digit)
+  if (0 < base) {
+    if (base <= digit || chr_is_lower(chr))
+      return -1 ;
+  } else if (base < 0) {
+    if (-base <= digit || chr_is_upper(chr))
       return -1 ;
   } else {
-    digit = cstr_chr(digits_lower, chr) ;
-
-    if (base <= digit)
+    if (36 <= digit)
       return -1 ;
   }
 
@@ -434,6 +686,9 @@ _RIGE_API i32_t cstr_n_comp (const cstr_t lhs, const cstr_t rhs, usiz_t n)
   for (size = 0 ; size < n && 0 != lhs[size] && lhs[size] == rhs[size] ; ++size)
     /* continue */ ;
 
+  if (size == n)
+    return 0 ;
+
   return (i32_t)lhs[size] - (i32_t)rhs[size] ;
 }
 
@@ -857,4 +1112,3878 @@ _RIGE_API i32_t str_n_comp (const str_t * lhs, const cstr_t rhs, usiz_t n)
 #endif
 
   return cstr_n_comp(lhs->data, rhs, n) ;
+}
+
+/* ----------------------------------------------------------------
+ * strbuf
+ */
+
+_RIGE_API void strbuf_init (strbuf_t * sb)
+{
+  if (RIGE_NULL == sb)
+    return ;
+
+  sb->data     = RIGE_NULL ;
+  sb->size     = 0 ;
+  sb->capacity = 0 ;
+  sb->owned    = 1 ;
+}
+
+_RIGE_API void strbuf_init_with (strbuf_t * sb, ptr_t ptr, usiz_t n)
+{
+  if (RIGE_NULL == sb)
+    return ;
+
+  strbuf_init(sb) ;
+
+  /* `ptr` is borrowed (stack, arena, ...), it is never freed and the
+   * first growth past `n` moves the contents to the heap
+   */
+  if (RIGE_NULL != ptr && 0 != n) {
+    sb->data     = (chr_t *)ptr ;
+    sb->capacity = n ;
+    sb->owned    = 0 ;
+    sb->data[0]  = 0 ;
+  }
+}
+
+_RIGE_API void strbuf_free (strbuf_t * sb)
+{
+  if (RIGE_NULL == sb)
+    return ;
+
+  if (0 != sb->owned) {
+    mem_dealloc(sb->data) ;
+  }
+
+  strbuf_init(sb) ;
+}
+
+_RIGE_API void strbuf_clear (strbuf_t * sb)
+{
+  if (RIGE_NULL == sb)
+    return ;
+
+  sb->size = 0 ;
+
+  if (RIGE_NULL != sb->data) {
+    sb->data[0] = 0 ;
+  }
+}
+
+_RIGE_API usiz_t strbuf_reserve (strbuf_t * sb, usiz_t n)
+{
+  if (RIGE_NULL == sb)
+    return RIGE_NPOS ;
+
+  /* room for `n` more characters and the terminator */
+  if (RIGE_NPOS - sb->size - 1 < n)
+    return RIGE_NPOS ;
+
+  usiz_t need = sb->size + n + 1 ;
+
+  if (need <= sb->capacity)
+    return sb->capacity ;
+
+  /* grow geometrically, so `n` appends cost O(n) copies in total. past
+   * half the address space doubling would wrap, take just what is needed
+   */
+  usiz_t capacity = sb->capacity < 16 ? 16 : sb->capacity ;
+
+  while (capacity < need)
+    capacity = RIGE_NPOS / 2 < capacity ? need : capacity * 2 ;
+
+  chr_t * data ;
+
+  if (0 != sb->owned) {
+    data = (chr_t *)mem_realloc(sb->data, capacity) ;
+  } else {
+    data = (chr_t *)mem_alloc(capacity) ;
+
+    if (RIGE_NULL != data && RIGE_NULL != sb->data) {
+      mem_copy(data, sb->data, sb->size + 1) ;
+    }
+  }
+
+  if (RIGE_NULL == data)
+    return RIGE_NPOS ;
+
+  if (RIGE_NULL == sb->data) {
+    data[0] = 0 ;
+  }
+
+  sb->data     = data ;
+  sb->capacity = capacity ;
+  sb->owned    = 1 ;
+
+  return capacity ;
+}
+
+_RIGE_API usiz_t strbuf_append (strbuf_t * sb, const cstr_t cstr)
+{
+  return strbuf_n_append(sb, cstr, cstr_size(cstr)) ;
+}
+
+_RIGE_API usiz_t strbuf_n_append (strbuf_t * sb, const cstr_t cstr, usiz_t n)
+{
+  if (RIGE_NULL == sb || RIGE_NULL == cstr)
+    return RIGE_NPOS ;
+
+  /* a slice of the buffer itself moves with it when it grows */
+  uptr_t src = (uptr_t)cstr ;
+  uptr_t own = (uptr_t)sb->data ;
+  usiz_t inside = RIGE_NULL != sb->data && own <= src && src < own + sb->capacity ;
+
+  if (RIGE_NPOS == strbuf_reserve(sb, n))
+    return RIGE_NPOS ;
+
+  chr_t * from = 0 != inside ? sb->data + (src - own) : (chr_t *)cstr ;
+
+  mem_copy(sb->data + sb->size, from, n) ;
+
+  sb->size += n ;
+  sb->data[sb->size] = 0 ;
+
+  return sb->size ;
+}
+
+_RIGE_API usiz_t strbuf_append_str (strbuf_t * sb, const str_t * str)
+{
+  if (RIGE_NULL == str)
+    return RIGE_NPOS ;
+
+  return strbuf_n_append(sb, str->data, str->size) ;
+}
+
+_RIGE_API usiz_t strbuf_append_chr (strbuf_t * sb, chr_t chr)
+{
+  if (RIGE_NULL == sb)
+    return RIGE_NPOS ;
+
+  if (RIGE_NPOS == strbuf_reserve(sb, 1))
+    return RIGE_NPOS ;
+
+  sb->data[sb->size++] = chr ;
+  sb->data[sb->size] = 0 ;
+
+  return sb->size ;
+}
+
+_RIGE_API usiz_t strbuf_append_u64 (strbuf_t * sb, u64_t val, i32_t base)
+{
+  if (RIGE_NULL == sb)
+    return RIGE_NPOS ;
+
+  /* format in place, `num_fmt_u64` writes the terminator too */
+  if (RIGE_NPOS == strbuf_reserve(sb, NUM_MAX_SIZE))
+    return RIGE_NPOS ;
+
+  usiz_t size = num_fmt_u64(sb->data + sb->size, sb->capacity - sb->size, val, base) ;
+
+  if (RIGE_NPOS == size)
+    return RIGE_NPOS ;
+
+  sb->size += size ;
+
+  return sb->size ;
+}
+
+_RIGE_API usiz_t strbuf_append_i64 (strbuf_t * sb, i64_t val, i32_t base)
+{
+  if (RIGE_NULL == sb)
+    return RIGE_NPOS ;
+
+  if (RIGE_NPOS == strbuf_reserve(sb, NUM_MAX_SIZE))
+    return RIGE_NPOS ;
+
+  usiz_t size = num_fmt_i64(sb->data + sb->size, sb->capacity - sb->size, val, base) ;
+
+  if (RIGE_NPOS == size)
+    return RIGE_NPOS ;
+
+  sb->size += size ;
+
+  return sb->size ;
+}
+
+_RIGE_API str_t strbuf_to_str (strbuf_t * sb)
+{
+  str_t str ;
+
+  if (RIGE_NULL == sb) {
+    str.data = RIGE_NULL ;
+    str.size = 0 ;
+#ifdef _RIGE_HAS_HASH_STRING
+    str.hash = 0 ;
+#endif
+
+    return str ;
+  }
+
+  /* a borrowed buffer cannot be handed off, copy it */
+  if (0 == sb->owned) {
+    str = str_n_make(sb->data, sb->size) ;
+    strbuf_init(sb) ;
+
+    return str ;
+  }
+
+  str.data = sb->data ;
+  str.size = sb->size ;
+#ifdef _RIGE_HAS_HASH_STRING
+  str.hash = cstr_n_hash_djb2(sb->data, sb->size) ;
+#endif
+
+  /* the buffer now belongs to `str` */
+  strbuf_init(sb) ;
+
+  return str ;
+}
+
+/* ----------------------------------------------------------------
+ * utf8
+ */
+
+#define _HI_BITS 0x8080808080808080ULL
+#define _LO_BITS 0x0101010101010101ULL
+
+static inline u64_t _load_u64 (const u8_t * ptr)
+{
+  u64_t word ;
+
+  /* the compiler turns it into a single unaligned load */
+  memcpy(&word, ptr, sizeof(word)) ;
+
+  return word ;
+}
+
+/* non-zero if any of the 8 bytes is a control character. the bytes are
+ * expected to be 7-bit ASCII
+ */
+static inline u64_t _has_cntrl_u64 (u64_t word)
+{
+  u64_t del = word ^ (0x7F * _LO_BITS) ;
+
+  return ((word - 0x20 * _LO_BITS) | (del - _LO_BITS)) & ~(word & del) & _HI_BITS ;
+}
+
+_RIGE_API usiz_t utf8_decode (const ptr_t _ptr, usiz_t n, i32_t * cp)
+{
+  u8_t * ptr = (u8_t *)_ptr ;
+
+  if (RIGE_NULL == ptr || 0 == n)
+    return RIGE_NPOS ;
+
+  u32_t chr = ptr[0] ;
+  u32_t min ;
+  usiz_t size ;
+
+  if (chr < 0x80) {
+    size = 1 ;
+    min  = 0 ;
+  } else if (0xC0 == (chr & 0xE0)) {
+    size = 2 ;
+    min  = 0x80 ;
+    chr &= 0x1F ;
+  } else if (0xE0 == (chr & 0xF0)) {
+    size = 3 ;
+    min  = 0x800 ;
+    chr &= 0x0F ;
+  } else if (0xF0 == (chr & 0xF8)) {
+    size = 4 ;
+    min  = 0x10000 ;
+    chr &= 0x07 ;
+  } else {
+    return RIGE_NPOS ;
+  }
+
+  if (n < size)
+    return RIGE_NPOS ;
+
+  for (usiz_t i = 1 ; i < size ; ++i) {
+    if (0x80 != (ptr[i] & 0xC0))
+      return RIGE_NPOS ;
+
+    chr = (chr << 6) | (ptr[i] & 0x3F) ;
+  }
+
+  /* reject overlong forms, surrogates and anything past U+10FFFF */
+  if (chr < min || 0x10FFFF < chr || (0xD800 <= chr && chr <= 0xDFFF))
+    return RIGE_NPOS ;
+
+  if (RIGE_NULL != cp) {
+    *cp = (i32_t)chr ;
+  }
+
+  return size ;
+}
+
+_RIGE_API usiz_t utf8_encode (ptr_t _ptr, usiz_t n, i32_t cp)
+{
+  u8_t * ptr = (u8_t *)_ptr ;
+
+  if (RIGE_NULL == ptr || cp < 0 || 0x10FFFF < cp || (0xD800 <= cp && cp <= 0xDFFF))
+    return RIGE_NPOS ;
+
+  if (cp < 0x80) {
+    if (n < 1)
+      return RIGE_NPOS ;
+
+    ptr[0] = cp ;
+
+    return 1 ;
+  }
+
+  if (cp < 0x800) {
+    if (n < 2)
+      return RIGE_NPOS ;
+
+    ptr[0] = 0xC0 | (cp >> 6) ;
+    ptr[1] = 0x80 | (cp & 0x3F) ;
+
+    return 2 ;
+  }
+
+  if (cp < 0x10000) {
+    if (n < 3)
+      return RIGE_NPOS ;
+
+    ptr[0] = 0xE0 | (cp >> 12) ;
+    ptr[1] = 0x80 | ((cp >> 6) & 0x3F) ;
+    ptr[2] = 0x80 | (cp & 0x3F) ;
+
+    return 3 ;
+  }
+
+  if (n < 4)
+    return RIGE_NPOS ;
+
+  ptr[0] = 0xF0 | (cp >> 18) ;
+  ptr[1] = 0x80 | ((cp >> 12) & 0x3F) ;
+  ptr[2] = 0x80 | ((cp >> 6) & 0x3F) ;
+  ptr[3] = 0x80 | (cp & 0x3F) ;
+
+  return 4 ;
+}
+
+_RIGE_API usiz_t utf8_valid (const ptr_t _ptr, usiz_t n)
+{
+  u8_t * ptr = (u8_t *)_ptr ;
+
+  if (RIGE_NULL == ptr)
+    return RIGE_NPOS ;
+
+  usiz_t size = 0 ;
+
+  while (size < n) {
+    /* names and map files are mostly ASCII, skip it 8 bytes at a time */
+    if (size + 8 <= n && 0 == (_load_u64(ptr + size) & _HI_BITS)) {
+      size += 8 ;
+      continue ;
+    }
+
+    usiz_t step = utf8_decode(ptr + size, n - size, RIGE_NULL) ;
+
+    if (RIGE_NPOS == step)
+      break ;
+
+    size += step ;
+  }
+
+  /* length of the longest valid prefix, `n` if the whole buffer is valid */
+  return size ;
+}
+
+_RIGE_API usiz_t utf8_count (const ptr_t _ptr, usiz_t n)
+{
+  u8_t * ptr = (u8_t *)_ptr ;
+
+  if (RIGE_NULL == ptr)
+    return RIGE_NPOS ;
+
+  usiz_t count = 0 ;
+  usiz_t size = 0 ;
+
+  /* every byte that is not a continuation byte (10xxxxxx) starts a code
+   * point. continuation bytes are summed 8 at a time into byte lanes,
+   * which hold up to 255 words before they are added up
+   */
+  while (size + 8 <= n) {
+    u64_t lanes = 0 ;
+
+    for (usiz_t k = 0 ; k < 255 && size + 8 <= n ; ++k, size += 8) {
+      u64_t word = _load_u64(ptr + size) ;
+
+      lanes += ((word & ~(word << 1)) & _HI_BITS) >> 7 ;
+    }
+
+    lanes  = (lanes & 0x00FF00FF00FF00FFULL) + ((lanes >> 8) & 0x00FF00FF00FF00FFULL) ;
+    count += (lanes * 0x0001000100010001ULL) >> 48 ;
+  }
+
+  count = size - count ;
+
+  for (; size < n ; ++size)
+    count += 0x80 != (ptr[size] & 0xC0) ;
+
+  return count ;
+}
+
+_RIGE_API i32_t utf8_cp_width (i32_t cp)
+{
+  /* a small subset of `wcwidth` (see Markus Kuhn's implementation), good
+   * enough for names typed on a terminal
+   */
+  static const i32_t zero [][2] = {
+    { 0x0300 , 0x036F } , { 0x0483 , 0x0489 } , { 0x0591 , 0x05BD } ,
+    { 0x0610 , 0x061A } , { 0x064B , 0x065F } , { 0x0E31 , 0x0E31 } ,
+    { 0x0E34 , 0x0E3A } , { 0x0E47 , 0x0E4E } , { 0x1AB0 , 0x1AFF } ,
+    { 0x1DC0 , 0x1DFF } , { 0x200B , 0x200F } , { 0x202A , 0x202E } ,
+    { 0x2060 , 0x2064 } , { 0x20D0 , 0x20FF } , { 0xFE00 , 0xFE0F } ,
+    { 0xFE20 , 0xFE2F } , { 0xFEFF , 0xFEFF }
+  } ;
+
+  static const i32_t wide [][2] = {
+    { 0x1100  , 0x115F  } , { 0x2E80  , 0x303E  } , { 0x3041  , 0x33FF  } ,
+    { 0x3400  , 0x4DBF  } , { 0x4E00  , 0x9FFF  } , { 0xA000  , 0xA4CF  } ,
+    { 0xAC00  , 0xD7A3  } , { 0xF900  , 0xFAFF  } , { 0xFE30  , 0xFE4F  } ,
+    { 0xFF00  , 0xFF60  } , { 0xFFE0  , 0xFFE6  } , { 0x1F300 , 0x1F64F } ,
+    { 0x1F900 , 0x1F9FF } , { 0x20000 , 0x2FFFD } , { 0x30000 , 0x3FFFD }
+  } ;
+
+  /* the space is not `chr_is_print` but it still takes a column */
+  if (cp < 0x80)
+    return 0x20 <= cp && 0x7F != cp ;
+
+  /* C1 controls */
+  if (cp < 0xA0)
+    return 0 ;
+
+  for (usiz_t i = 0 ; i < sizeof(zero) / sizeof(zero[0]) && zero[i][0] <= cp ; ++i) {
+    if (cp <= zero[i][1])
+      return 0 ;
+  }
+
+  for (usiz_t i = 0 ; i < sizeof(wide) / sizeof(wide[0]) && wide[i][0] <= cp ; ++i) {
+    if (cp <= wide[i][1])
+      return 2 ;
+  }
+
+  return 1 ;
+}
+
+_RIGE_API usiz_t utf8_width (const ptr_t _ptr, usiz_t n)
+{
+  u8_t * ptr = (u8_t *)_ptr ;
+
+  if (RIGE_NULL == ptr)
+    return RIGE_NPOS ;
+
+  usiz_t width = 0 ;
+  usiz_t size = 0 ;
+
+  while (size < n) {
+    /* printable ASCII is always one column wide */
+    if (size + 8 <= n) {
+      u64_t word = _load_u64(ptr + size) ;
+
+      if (0 == (word & _HI_BITS) && 0 == _has_cntrl_u64(word)) {
+        width += 8 ;
+        size  += 8 ;
+        continue ;
+      }
+    }
+
+    i32_t cp ;
+    usiz_t step = utf8_decode(ptr + size, n - size, &cp) ;
+
+    /* an invalid byte is shown as U+FFFD */
+    if (RIGE_NPOS == step) {
+      width += 1 ;
+      size  += 1 ;
+      continue ;
+    }
+
+    width += utf8_cp_width(cp) ;
+    size  += step ;
+  }
+
+  return width ;
+}
+
+_RIGE_API usiz_t utf8_find_cntrl (const ptr_t _ptr, usiz_t n)
+{
+  u8_t * ptr = (u8_t *)_ptr ;
+
+  if (RIGE_NULL == ptr)
+    return RIGE_NPOS ;
+
+  usiz_t size = 0 ;
+
+  while (size < n) {
+    if (size + 8 <= n) {
+      u64_t word = _load_u64(ptr + size) ;
+
+      if (0 == (word & _HI_BITS) && 0 == _has_cntrl_u64(word)) {
+        size += 8 ;
+        continue ;
+      }
+    }
+
+    i32_t cp ;
+    usiz_t step = utf8_decode(ptr + size, n - size, &cp) ;
+
+    /* invalid sequences are not printable either */
+    if (RIGE_NPOS == step || cp < 0x20 || (0x7F <= cp && cp < 0xA0))
+      return size ;
+
+    size += step ;
+  }
+
+  return RIGE_NPOS ;
+}
+
+#undef _HI_BITS
+#undef _LO_BITS
+
+
+/* ----------------------------------------------------------------
+ * num
+ */
+
+#define _NUM_SWAR_MAX ((~(u64_t)0 - 99999999) / 100000000)
+
+/* value of 8 decimal digits, the first one in the lowest byte */
+static inline u64_t _num_parse_8_digits (u64_t word)
+{
+  word = (word & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8 ;
+  word = (word & 0x00FF00FF00FF00FFULL) * 6553601 >> 16 ;
+
+  return (word & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32 ;
+}
+
+_RIGE_API usiz_t num_parse_u64 (const cstr_t cstr, usiz_t n, i32_t base, u64_t * val)
+{
+  /* `base` follows `chr_to_digit`, so the sign selects the letter case */
+  i32_t radix = base < 0 ? -base : base ;
+
+  if (RIGE_NULL == cstr || 1 == radix || 36 < radix)
+    return RIGE_NPOS ;
+
+  u8_t * ptr = (u8_t *)cstr ;
+  u64_t retval = 0 ;
+  usiz_t size = 0 ;
+
+  /* `base` == 0 takes the radix from a `0x`, `0o` or `0b` prefix and is
+   * decimal without one, letters of both cases are accepted
+   */
+  if (0 == radix) {
+    radix = 10 ;
+
+    if (3 <= n && '0' == ptr[0] && 0 != ptr[1]) {
+      i32_t prefix = 'x' == (ptr[1] | 0x20) ? 16 : 'o' == (ptr[1] | 0x20) ? 8 : 'b' == (ptr[1] | 0x20) ? 2 : 0 ;
+
+      if (0 != prefix && 0 <= chr_to_digit(ptr[2], 0) && chr_to_digit(ptr[2], 0) < prefix) {
+        radix = prefix ;
+        ptr  += 2 ;
+        n    -= 2 ;
+      }
+    }
+  }
+
+  const u64_t lim = ~(u64_t)0 / radix ;
+  const u64_t rem = ~(u64_t)0 % radix ;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  /* long runs of decimal digits are converted 8 at a time, the run is
+   * measured first so no byte past it or the terminator is read
+   */
+  if (10 == radix) {
+    usiz_t run ;
+
+    for (run = 0 ; run < n && _chr_digit_tab[ptr[run]] < 10 ; ++run)
+      /* continue */ ;
+
+    while (size + 8 <= run && retval <= _NUM_SWAR_MAX) {
+      retval = retval * 100000000 + _num_parse_8_digits(_load_u64(ptr + size)) ;
+      size  += 8 ;
+    }
+  }
+#endif
+
+  for (; size < n ; ++size) {
+    i32_t digit = chr_to_digit(ptr[size], base) ;
+
+    if (digit < 0 || radix <= digit)
+      break ;
+
+    /* overflow */
+    if (lim < retval || (lim == retval && rem < (u64_t)digit))
+      return RIGE_NPOS ;
+
+    retval = retval * radix + digit ;
+  }
+
+  if (0 == size)
+    return RIGE_NPOS ;
+
+  if (RIGE_NULL != val) {
+    *val = retval ;
+  }
+
+  return size + (ptr - (u8_t *)cstr) ;
+}
+
+_RIGE_API usiz_t num_parse_i64 (const cstr_t cstr, usiz_t n, i32_t base, i64_t * val)
+{
+  if (RIGE_NULL == cstr || 0 == n)
+    return RIGE_NPOS ;
+
+  usiz_t sign = '-' == cstr[0] || '+' == cstr[0] ;
+  u64_t limit = (u64_t)INT64_MAX + ('-' == cstr[0]) ;
+  u64_t mag ;
+
+  usiz_t size = num_parse_u64(cstr + sign, n - sign, base, &mag) ;
+
+  if (RIGE_NPOS == size || limit < mag)
+    return RIGE_NPOS ;
+
+  if (RIGE_NULL != val) {
+    *val = '-' == cstr[0] ? (i64_t)(0 - mag) : (i64_t)mag ;
+  }
+
+  return sign + size ;
+}
+
+_RIGE_API usiz_t num_fmt_u64 (cstr_t dst, usiz_t n, u64_t val, i32_t base)
+{
+  static const chr_t pairs [] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899" ;
+
+  /* `base` follows `chr_to_digit`, so the sign selects the letter case */
+  const chr_t * digits = base < 0
+    ? "0123456789abcdefghijklmnopqrstuvwxyz"
+    : "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ" ;
+
+  i32_t radix = base < 0 ? -base : base ;
+
+  if (RIGE_NULL == dst || radix < 2 || 36 < radix)
+    return RIGE_NPOS ;
+
+  /* enough for 2^64 - 1 in base 2 */
+  chr_t tmp [64] ;
+  usiz_t pos = sizeof(tmp) ;
+
+  if (10 == radix) {
+    /* two digits per division */
+    while (100 <= val) {
+      usiz_t pair = (val % 100) * 2 ;
+
+      val /= 100 ;
+      tmp[--pos] = pairs[pair + 1] ;
+      tmp[--pos] = pairs[pair + 0] ;
+    }
+
+    if (10 <= val) {
+      tmp[--pos] = pairs[val * 2 + 1] ;
+      tmp[--pos] = pairs[val * 2 + 0] ;
+    } else {
+      tmp[--pos] = digits[val] ;
+    }
+  } else {
+    do {
+      tmp[--pos] = digits[val % radix] ;
+      val /= radix ;
+    } while (0 != val) ;
+  }
+
+  usiz_t size = sizeof(tmp) - pos ;
+
+  /* leave room for the terminator */
+  if (n <= size)
+    return RIGE_NPOS ;
+
+  mem_copy(dst, tmp + pos, size) ;
+  dst[size] = 0 ;
+
+  return size ;
+}
+
+_RIGE_API usiz_t num_fmt_i64 (cstr_t dst, usiz_t n, i64_t val, i32_t base)
+{
+  if (RIGE_NULL == dst || 0 == n)
+    return RIGE_NPOS ;
+
+  if (0 <= val)
+    return num_fmt_u64(dst, n, (u64_t)val, base) ;
+
+  dst[0] = '-' ;
+
+  usiz_t size = num_fmt_u64(dst + 1, n - 1, 0 - (u64_t)val, base) ;
+
+  if (RIGE_NPOS == size)
+    return RIGE_NPOS ;
+
+  return size + 1 ;
+}
+
+#undef _NUM_SWAR_MAX
+
+
+/* ----------------------------------------------------------------
+ * chan
+ */
+
+#include <sched.h>
+
+#ifdef __linux__
+# include <linux/futex.h>
+# include <sys/syscall.h>
+#endif
+
+/* times `chan_wait_pop` yields to the producers before it sleeps */
+#define _CHAN_SPIN 8
+
+static void _chan_sleep (_Atomic u32_t * word, u32_t val)
+{
+#ifdef __linux__
+  syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, val, RIGE_NULL, RIGE_NULL, 0) ;
+#else
+  /* maybe later a platform-specific implementation */
+  if (val == atomic_load(word)) {
+    sched_yield() ;
+  }
+#endif
+}
+
+static void _chan_wake (_Atomic u32_t * word)
+{
+#ifdef __linux__
+  syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, 1, RIGE_NULL, RIGE_NULL, 0) ;
+#else
+  (void)word ;
+#endif
+}
+
+/* called by the producers after publishing, wakes a sleeping consumer */
+static void _chan_signal (chan_t * ch)
+{
+  if (0 == (ch->flags & CHAN_BLOCKING))
+    return ;
+
+  /* pairs with the fence in `chan_wait_pop`, either the consumer sees the
+   * new messages or we see it waiting
+   */
+  atomic_thread_fence(memory_order_seq_cst) ;
+
+  /* only the first producer to see the consumer waiting wakes it, the
+   * others would make a syscall for every message until it runs
+   */
+  if (0 != atomic_load_explicit(&ch->waiters, memory_order_relaxed) && 0 != atomic_exchange_explicit(&ch->waiters, 0, memory_order_relaxed)) {
+    atomic_fetch_add_explicit(&ch->signal, 1, memory_order_relaxed) ;
+    _chan_wake(&ch->signal) ;
+  }
+}
+
+_RIGE_API usiz_t chan_init (chan_t * ch, usiz_t elem_size, usiz_t n, i32_t flags)
+{
+  if (RIGE_NULL == ch || 0 == elem_size || 0 == n)
+    return RIGE_NPOS ;
+
+  /* round up to a power of two so indices wrap with a mask */
+  usiz_t capacity = 1 ;
+
+  while (capacity < n)
+    capacity <<= 1 ;
+
+  ch->data = (u8_t *)mem_alloc(capacity * elem_size) ;
+  ch->seq  = RIGE_NULL ;
+
+  if (RIGE_NULL == ch->data)
+    return RIGE_NPOS ;
+
+  if (0 != (flags & CHAN_MPSC)) {
+    ch->seq = (_Atomic usiz_t *)mem_alloc(capacity * sizeof(_Atomic usiz_t)) ;
+
+    if (RIGE_NULL == ch->seq) {
+      mem_dealloc(ch->data) ;
+      ch->data = RIGE_NULL ;
+
+      return RIGE_NPOS ;
+    }
+
+    /* slot `i` is free for the producer that claims position `i` */
+    for (usiz_t i = 0 ; i < capacity ; ++i)
+      atomic_init(&ch->seq[i], i) ;
+  }
+
+  atomic_init(&ch->tail, 0) ;
+  atomic_init(&ch->head, 0) ;
+  atomic_init(&ch->signal, 0) ;
+  atomic_init(&ch->waiters, 0) ;
+
+  ch->head_cache = 0 ;
+  ch->tail_cache = 0 ;
+  ch->elem_size  = elem_size ;
+  ch->mask       = capacity - 1 ;
+  ch->flags      = flags ;
+
+  return capacity ;
+}
+
+_RIGE_API void chan_free (chan_t * ch)
+{
+  if (RIGE_NULL == ch)
+    return ;
+
+  mem_dealloc(ch->data) ;
+  mem_dealloc((ptr_t)ch->seq) ;
+
+  ch->data = RIGE_NULL ;
+  ch->seq  = RIGE_NULL ;
+}
+
+/* copy `n` messages between the ring and a flat buffer, wrapping around */
+static void _chan_copy (chan_t * ch, usiz_t pos, u8_t * buf, usiz_t n, i32_t to_ring)
+{
+  usiz_t start = pos & ch->mask ;
+  usiz_t first = ch->mask + 1 - start ;
+
+  if (n < first) {
+    first = n ;
+  }
+
+  u8_t * ring = ch->data + start * ch->elem_size ;
+
+  if (0 != to_ring) {
+    mem_copy(ring, buf, first * ch->elem_size) ;
+    mem_copy(ch->data, buf + first * ch->elem_size, (n - first) * ch->elem_size) ;
+  } else {
+    mem_copy(buf, ring, first * ch->elem_size) ;
+    mem_copy(buf + first * ch->elem_size, ch->data, (n - first) * ch->elem_size) ;
+  }
+}
+
+static usiz_t _chan_push_spsc (chan_t * ch, u8_t * src, usiz_t n)
+{
+  usiz_t capacity = ch->mask + 1 ;
+  usiz_t tail = atomic_load_explicit(&ch->tail, memory_order_relaxed) ;
+
+  /* only look at the consumer's line when the cached view is not enough */
+  if (capacity - (tail - ch->head_cache) < n) {
+    ch->head_cache = atomic_load_explicit(&ch->head, memory_order_acquire) ;
+  }
+
+  usiz_t room = capacity - (tail - ch->head_cache) ;
+
+  if (room < n) {
+    n = room ;
+  }
+
+  if (0 == n)
+    return 0 ;
+
+  _chan_copy(ch, tail, src, n, 1) ;
+  atomic_store_explicit(&ch->tail, tail + n, memory_order_release) ;
+
+  return n ;
+}
+
+static usiz_t _chan_push_mpsc (chan_t * ch, u8_t * src, usiz_t n)
+{
+  usiz_t done = 0 ;
+
+  while (done < n) {
+    usiz_t tail = atomic_load_explicit(&ch->tail, memory_order_relaxed) ;
+    usiz_t want = n - done ;
+
+    /* the consumer frees slots in order, so if the last slot of the batch
+     * is free all of them are. otherwise settle for a single slot
+     */
+    usiz_t last = tail + want - 1 ;
+
+    if (last != atomic_load_explicit(&ch->seq[last & ch->mask], memory_order_acquire)) {
+      want = 1 ;
+
+      if (tail != atomic_load_explicit(&ch->seq[tail & ch->mask], memory_order_acquire)) {
+        /* full, or another producer moved `tail` since we read it */
+        if (tail == atomic_load_explicit(&ch->tail, memory_order_relaxed))
+          break ;
+
+        continue ;
+      }
+    }
+
+    if (0 == atomic_compare_exchange_weak_explicit(&ch->tail, &tail, tail + want, memory_order_relaxed, memory_order_relaxed))
+      continue ;
+
+    for (usiz_t i = 0 ; i < want ; ++i) {
+      usiz_t pos = tail + i ;
+
+      mem_copy(ch->data + (pos & ch->mask) * ch->elem_size, src + (done + i) * ch->elem_size, ch->elem_size) ;
+      atomic_store_explicit(&ch->seq[pos & ch->mask], pos + 1, memory_order_release) ;
+    }
+
+    done += want ;
+  }
+
+  return done ;
+}
+
+_RIGE_API usiz_t chan_push (chan_t * ch, const ptr_t src, usiz_t n)
+{
+  if (RIGE_NULL == ch || RIGE_NULL == src)
+    return RIGE_NPOS ;
+
+  usiz_t done = 0 != (ch->flags & CHAN_MPSC)
+    ? _chan_push_mpsc(ch, (u8_t *)src, n)
+    : _chan_push_spsc(ch, (u8_t *)src, n) ;
+
+  if (0 != done) {
+    _chan_signal(ch) ;
+  }
+
+  /* number of messages pushed, less than `n` if the channel is full */
+  return done ;
+}
+
+_RIGE_API usiz_t chan_pop (chan_t * ch, ptr_t _dst, usiz_t n)
+{
+  u8_t * dst = (u8_t *)_dst ;
+
+  if (RIGE_NULL == ch || RIGE_NULL == dst)
+    return RIGE_NPOS ;
+
+  usiz_t head = atomic_load_explicit(&ch->head, memory_order_relaxed) ;
+  usiz_t done ;
+
+  if (0 != (ch->flags & CHAN_MPSC)) {
+    for (done = 0 ; done < n ; ++done) {
+      usiz_t pos = head + done ;
+
+      if (pos + 1 != atomic_load_explicit(&ch->seq[pos & ch->mask], memory_order_acquire))
+        break ;
+
+      mem_copy(dst + done * ch->elem_size, ch->data + (pos & ch->mask) * ch->elem_size, ch->elem_size) ;
+
+      /* hand the slot to the producer of the next lap */
+      atomic_store_explicit(&ch->seq[pos & ch->mask], pos + ch->mask + 1, memory_order_release) ;
+    }
+  } else {
+    if (ch->tail_cache - head < n) {
+      ch->tail_cache = atomic_load_explicit(&ch->tail, memory_order_acquire) ;
+    }
+
+    done = ch->tail_cache - head ;
+
+    if (n < done) {
+      done = n ;
+    }
+
+    _chan_copy(ch, head, dst, done, 0) ;
+  }
+
+  if (0 != done) {
+    atomic_store_explicit(&ch->head, head + done, memory_order_release) ;
+  }
+
+  return done ;
+}
+
+_RIGE_API usiz_t chan_wait_pop (chan_t * ch, ptr_t dst, usiz_t n)
+{
+  if (RIGE_NULL == ch || 0 == (ch->flags & CHAN_BLOCKING) || 0 == n)
+    return chan_pop(ch, dst, n) ;
+
+  /* a sleep costs two syscalls and a context switch, so give the
+   * producers a few chances to push first
+   */
+  for (usiz_t spin = 0 ; spin < _CHAN_SPIN ; ++spin) {
+    usiz_t done = chan_pop(ch, dst, n) ;
+
+    if (0 != done)
+      return done ;
+
+    sched_yield() ;
+  }
+
+  for (;;) {
+    usiz_t done = chan_pop(ch, dst, n) ;
+
+    if (0 != done)
+      return done ;
+
+    u32_t signal = atomic_load_explicit(&ch->signal, memory_order_relaxed) ;
+
+    atomic_store_explicit(&ch->waiters, 1, memory_order_relaxed) ;
+    atomic_thread_fence(memory_order_seq_cst) ;
+
+    /* check again, a producer could have pushed before seeing `waiters` */
+    done = chan_pop(ch, dst, n) ;
+
+    if (0 == done) {
+      _chan_sleep(&ch->signal, signal) ;
+    }
+
+    atomic_store_explicit(&ch->waiters, 0, memory_order_relaxed) ;
+
+    if (0 != done)
+      return done ;
+  }
+}
+
+/* ----------------------------------------------------------------
+ * eval
+ */
+
+static const char * _eval_names [EVAL_FEATURES] = {
+  "border_ratio" ,
+  "continent"    ,
+  "income"       ,
+  "cards"
+} ;
+
+_RIGE_API void eval_init (eval_t * ev)
+{
+  if (RIGE_NULL == ev)
+    return ;
+
+  /* hand-picked defaults, tune them with `eval_load`. being stronger on
+   * the borders stops paying off past 3 to 1
+   */
+  static const f32_t weight [EVAL_FEATURES] = { 1.00f , 2.00f , 0.50f , 0.25f } ;
+  static const f32_t knee   [EVAL_FEATURES] = { 3.00f , 1e9f  , 1e9f  , 5.00f } ;
+  static const f32_t slope  [EVAL_FEATURES] = { 0.10f , 0.00f , 0.00f , 0.00f } ;
+
+  for (i32_t f = 0 ; f < EVAL_FEATURES ; ++f) {
+    ev->weight[f] = weight[f] ;
+    ev->knee[f]   = knee[f] ;
+    ev->slope[f]  = slope[f] ;
+  }
+
+  ev->bias = 0.0f ;
+}
+
+static usiz_t _eval_load (eval_t * ev, const cstr_t path)
+{
+  if (RIGE_NULL == ev || RIGE_NULL == path)
+    return RIGE_NPOS ;
+
+  FILE * file = fopen(path, "r") ;
+
+  if (RIGE_NULL == file)
+    return RIGE_NPOS ;
+
+  /* one entry per line, `#` starts a comment:
+   *
+   *   bias   <value>
+   *   <name> <weight> [<knee> <slope>]
+   *
+   * anything else fails the whole file and leaves `ev` as it was
+   */
+  eval_t tmp = *ev ;
+  chr_t line [256] ;
+  usiz_t count = 0 ;
+  i32_t failed = 0 ;
+
+  while (RIGE_NULL != fgets(line, sizeof(line), file)) {
+    usiz_t end = cstr_chr(line, '\n') ;
+
+    /* a line longer than the buffer would be read as two */
+    if (RIGE_NPOS == end && 0 == feof(file)) {
+      failed = 1 ;
+      break ;
+    }
+
+    end = cstr_chr(line, '#') ;
+
+    if (RIGE_NPOS != end) {
+      line[end] = 0 ;
+    }
+
+    chr_t * ptr = line + cstr_for_each(line, chr_is_space) ;
+
+    if (0 == *ptr)
+      continue ;
+
+    usiz_t size = cstr_for_each(ptr, chr_is_graph) ;
+    i32_t f = -1 ;
+
+    if (4 != size || 0 != cstr_n_comp(ptr, "bias", size)) {
+      for (f = 0 ; f < EVAL_FEATURES ; ++f) {
+        if (cstr_size((cstr_t)_eval_names[f]) == size && 0 == cstr_n_comp(ptr, (cstr_t)_eval_names[f], size))
+          break ;
+      }
+
+      if (EVAL_FEATURES == f) {
+        failed = 1 ;
+        break ;
+      }
+    }
+
+    f32_t val [3] ;
+    usiz_t n_val = 0 ;
+
+    for (ptr += size ;; ++n_val) {
+      ptr += cstr_for_each(ptr, chr_is_space) ;
+
+      if (0 == *ptr || 3 == n_val)
+        break ;
+
+      chr_t * next ;
+
+      val[n_val] = strtof(ptr, &next) ;
+
+      if (next == ptr || (0 != *next && 0 == chr_is_space(*next)))
+        break ;
+
+      ptr = next ;
+    }
+
+    /* the bias takes one value, a feature one or three */
+    if (0 != *ptr || (-1 == f ? 1 != n_val : 1 != n_val && 3 != n_val)) {
+      failed = 1 ;
+      break ;
+    }
+
+    if (-1 == f) {
+      tmp.bias = val[0] ;
+    } else {
+      /* without a knee the feature is plainly linear */
+      tmp.weight[f] = val[0] ;
+      tmp.knee[f]   = 3 == n_val ? val[1] : 1e9f ;
+      tmp.slope[f]  = 3 == n_val ? val[2] : 0.0f ;
+    }
+
+    ++count ;
+  }
+
+  if (0 != ferror(file)) {
+    failed = 1 ;
+  }
+
+  fclose(file) ;
+
+  if (0 != failed)
+    return RIGE_NPOS ;
+
+  *ev = tmp ;
+
+  return count ;
+}
+
+_RIGE_API usiz_t eval_load (eval_t * ev, const cstr_t path)
+{
+  RIGE_PROF_BEGIN(PROF_IO) ;
+
+  usiz_t retval = _eval_load(ev, path) ;
+
+  RIGE_PROF_END(PROF_IO) ;
+
+  return retval ;
+}
+
+_RIGE_API f32_t eval_one (const eval_t * ev, const f32_t * feat)
+{
+  if (RIGE_NULL == ev || RIGE_NULL == feat)
+    return 0.0f ;
+
+  f32_t score = ev->bias ;
+
+  for (i32_t f = 0 ; f < EVAL_FEATURES ; ++f) {
+    f32_t lo = feat[f] < ev->knee[f] ? feat[f] : ev->knee[f] ;
+    f32_t hi = feat[f] - lo ;
+
+    score += ev->weight[f] * lo + ev->slope[f] * hi ;
+  }
+
+  return score ;
+}
+
+_RIGE_API usiz_t eval_run (const eval_t * ev, const eval_batch_t * batch, f32_t * out)
+{
+  if (RIGE_NULL == ev || RIGE_NULL == batch || RIGE_NULL == out)
+    return RIGE_NPOS ;
+
+  _Alignas(RIGE_CACHE_LINE) f32_t score [EVAL_BATCH] ;
+
+  usiz_t size  = EVAL_BATCH < batch->size ? EVAL_BATCH : batch->size ;
+  usiz_t lanes = (size + 7) & ~(usiz_t)7 ;
+
+  /* feature-major, branch-free loops over whole vectors (8 lanes with
+   * AVX2), a small batch only pays for the lanes it uses
+   */
+  for (usiz_t i = 0 ; i < lanes ; ++i)
+    score[i] = ev->bias ;
+
+  for (i32_t f = 0 ; f < EVAL_FEATURES ; ++f) {
+    const f32_t * row = batch->feat[f] ;
+    f32_t weight = ev->weight[f] ;
+    f32_t knee   = ev->knee[f] ;
+    f32_t slope  = ev->slope[f] ;
+
+    /* keep it to one select, `x < knee ? x : knee` maps to minps while
+     * a second one would make gcc fall back to scalar branches
+     */
+    for (usiz_t i = 0 ; i < lanes ; ++i) {
+      f32_t lo = row[i] < knee ? row[i] : knee ;
+      f32_t hi = row[i] - lo ;
+
+      score[i] += weight * lo + slope * hi ;
+    }
+  }
+
+  mem_copy(out, score, size * sizeof(f32_t)) ;
+
+  return size ;
+}
+
+/* ----------------------------------------------------------------
+ * map
+ */
+
+static int _map_comp_u32 (const void * lhs, const void * rhs)
+{
+  u32_t a = *(const u32_t *)lhs ;
+  u32_t b = *(const u32_t *)rhs ;
+
+  return (a > b) - (a < b) ;
+}
+
+_RIGE_API usiz_t map_init (map_t * map, usiz_t n_terr, const u32_t * edges, usiz_t n_edges)
+{
+  if (RIGE_NULL == map || (0 != n_edges && RIGE_NULL == edges))
+    return RIGE_NPOS ;
+
+  map->n_terr     = n_terr ;
+  map->adj_off    = (u32_t *)mem_calloc(n_terr + 1, sizeof(u32_t)) ;
+  map->adj        = (u32_t *)mem_alloc(2 * n_edges * sizeof(u32_t)) ;
+  map->to_old     = RIGE_NULL ;
+  map->to_new     = RIGE_NULL ;
+  map->n_cont     = 0 ;
+  map->cont       = RIGE_NULL ;
+  map->cont_size  = RIGE_NULL ;
+  map->cont_bonus = RIGE_NULL ;
+  map->size.x     = 0 ;
+  map->size.y     = 0 ;
+  map->cells      = RIGE_NULL ;
+  map->epoch      = 0 ;
+
+  if (RIGE_NULL == map->adj_off || (0 != n_edges && RIGE_NULL == map->adj)) {
+    map_free(map) ;
+    return RIGE_NPOS ;
+  }
+
+  /* `edges` holds `n_edges` pairs, every border is stored both ways */
+  for (usiz_t i = 0 ; i < n_edges ; ++i) {
+    u32_t a = edges[2 * i + 0] ;
+    u32_t b = edges[2 * i + 1] ;
+
+    if (n_terr <= a || n_terr <= b || a == b)
+      continue ;
+
+    ++map->adj_off[a + 1] ;
+    ++map->adj_off[b + 1] ;
+  }
+
+  for (usiz_t t = 0 ; t < n_terr ; ++t)
+    map->adj_off[t + 1] += map->adj_off[t] ;
+
+  /* `fill` walks every list from its start */
+  u32_t * fill = (u32_t *)mem_alloc((n_terr + 1) * sizeof(u32_t)) ;
+
+  if (RIGE_NULL == fill) {
+    map_free(map) ;
+    return RIGE_NPOS ;
+  }
+
+  mem_copy(fill, map->adj_off, (n_terr + 1) * sizeof(u32_t)) ;
+
+  for (usiz_t i = 0 ; i < n_edges ; ++i) {
+    u32_t a = edges[2 * i + 0] ;
+    u32_t b = edges[2 * i + 1] ;
+
+    if (n_terr <= a || n_terr <= b || a == b)
+      continue ;
+
+    map->adj[fill[a]++] = b ;
+    map->adj[fill[b]++] = a ;
+  }
+
+  mem_dealloc(fill) ;
+
+  /* sorted lists do not depend on the order of `edges`, so `map_hash`
+   * is the same for every file describing the same borders
+   */
+  for (usiz_t t = 0 ; t < n_terr ; ++t) {
+    if (1 < map->adj_off[t + 1] - map->adj_off[t]) {
+      qsort(map->adj + map->adj_off[t], map->adj_off[t + 1] - map->adj_off[t], sizeof(u32_t), _map_comp_u32) ;
+    }
+  }
+
+  return n_terr ;
+}
+
+_RIGE_API void map_free (map_t * map)
+{
+  if (RIGE_NULL == map)
+    return ;
+
+  mem_dealloc(map->adj_off) ;
+  mem_dealloc(map->adj) ;
+  mem_dealloc(map->to_old) ;
+  mem_dealloc(map->to_new) ;
+  mem_dealloc(map->cont) ;
+  mem_dealloc(map->cont_size) ;
+  mem_dealloc(map->cont_bonus) ;
+  mem_dealloc(map->cells) ;
+
+  map->n_terr     = 0 ;
+  map->adj_off    = RIGE_NULL ;
+  map->adj        = RIGE_NULL ;
+  map->to_old     = RIGE_NULL ;
+  map->to_new     = RIGE_NULL ;
+  map->n_cont     = 0 ;
+  map->cont       = RIGE_NULL ;
+  map->cont_size  = RIGE_NULL ;
+  map->cont_bonus = RIGE_NULL ;
+  map->size.x     = 0 ;
+  map->size.y     = 0 ;
+  map->cells      = RIGE_NULL ;
+  map->epoch      = 0 ;
+}
+
+_RIGE_API usiz_t map_set_continents (map_t * map, usiz_t n_cont, const u32_t * cont, const u32_t * bonus)
+{
+  if (RIGE_NULL == map || RIGE_NULL == cont || RIGE_NULL == bonus || 0 == n_cont)
+    return RIGE_NPOS ;
+
+  u32_t * map_cont   = (u32_t *)mem_alloc(map->n_terr * sizeof(u32_t)) ;
+  u32_t * cont_size  = (u32_t *)mem_calloc(n_cont, sizeof(u32_t)) ;
+  u32_t * cont_bonus = (u32_t *)mem_alloc(n_cont * sizeof(u32_t)) ;
+
+  if (RIGE_NULL == map_cont || RIGE_NULL == cont_size || RIGE_NULL == cont_bonus) {
+    mem_dealloc(map_cont) ;
+    mem_dealloc(cont_size) ;
+    mem_dealloc(cont_bonus) ;
+
+    return RIGE_NPOS ;
+  }
+
+  /* `cont` is in the order of the map file, like every input */
+  for (u32_t t = 0 ; t < map->n_terr ; ++t) {
+    u32_t c = cont[map_to_old(map, t)] ;
+
+    if (n_cont <= c) {
+      mem_dealloc(map_cont) ;
+      mem_dealloc(cont_size) ;
+      mem_dealloc(cont_bonus) ;
+
+      return RIGE_NPOS ;
+    }
+
+    map_cont[t] = c ;
+    ++cont_size[c] ;
+  }
+
+  /* an empty continent would be owned by everybody and nobody */
+  for (u32_t c = 0 ; c < n_cont ; ++c) {
+    if (0 == cont_size[c]) {
+      mem_dealloc(map_cont) ;
+      mem_dealloc(cont_size) ;
+      mem_dealloc(cont_bonus) ;
+
+      return RIGE_NPOS ;
+    }
+  }
+
+  mem_copy(cont_bonus, (ptr_t)bonus, n_cont * sizeof(u32_t)) ;
+
+  mem_dealloc(map->cont) ;
+  mem_dealloc(map->cont_size) ;
+  mem_dealloc(map->cont_bonus) ;
+
+  map->n_cont     = n_cont ;
+  map->cont       = map_cont ;
+  map->cont_size  = cont_size ;
+  map->cont_bonus = cont_bonus ;
+
+  ++map->epoch ;
+
+  return n_cont ;
+}
+
+_RIGE_API u32_t map_hash (const map_t * map)
+{
+  if (RIGE_NULL == map || RIGE_NULL == map->adj_off)
+    return 0 ;
+
+  u32_t hash = mem_hash_djb2(map->adj_off, (map->n_terr + 1) * sizeof(u32_t)) ;
+
+  return ((hash << 5) + hash) ^ mem_hash_djb2(map->adj, map->adj_off[map->n_terr] * sizeof(u32_t)) ;
+}
+
+#define _map_degree(map, t) \
+  ((map)->adj_off[(t) + 1] - (map)->adj_off[(t)])
+
+/* repeated borders can push a degree past `n_terr - 1`, those sort last */
+static usiz_t _map_rcm_degree (const map_t * map, u32_t t)
+{
+  usiz_t degree = _map_degree(map, t) ;
+
+  return degree < map->n_terr ? degree : map->n_terr - 1 ;
+}
+
+/* reverse Cuthill-McKee order of the territories in `order`. `rank` and
+ * `by_rank` are scratch of `n_terr + 1` and `n_terr` entries
+ */
+static void _map_rcm (const map_t * map, u32_t * order, u8_t * seen, u32_t * rank, u32_t * by_rank)
+{
+  usiz_t n_terr = map->n_terr ;
+  usiz_t tail = 0 ;
+  usiz_t root = 0 ;
+
+  mem_set(seen, 0, n_terr) ;
+
+  /* territories by increasing degree, then by id, in a counting pass */
+  mem_set(rank, 0, (n_terr + 1) * sizeof(u32_t)) ;
+
+  for (u32_t t = 0 ; t < n_terr ; ++t)
+    ++rank[_map_rcm_degree(map, t) + 1] ;
+
+  for (usiz_t d = 1 ; d < n_terr ; ++d)
+    rank[d] += rank[d - 1] ;
+
+  for (u32_t t = 0 ; t < n_terr ; ++t)
+    by_rank[rank[_map_rcm_degree(map, t)]++] = t ;
+
+  for (u32_t r = 0 ; r < n_terr ; ++r)
+    rank[by_rank[r]] = r ;
+
+  while (tail < n_terr) {
+    /* start every component from a territory of minimum degree, it is
+     * cheap and usually close to the border of the component. the ones
+     * before `root` are all seen already
+     */
+    while (0 != seen[by_rank[root]])
+      ++root ;
+
+    usiz_t head = tail ;
+
+    seen[by_rank[root]] = 1 ;
+    order[tail++] = by_rank[root] ;
+
+    while (head < tail) {
+      u32_t t = order[head++] ;
+      usiz_t first = tail ;
+
+      for (u32_t i = map->adj_off[t] ; i < map->adj_off[t + 1] ; ++i) {
+        u32_t n = map->adj[i] ;
+
+        if (0 == seen[n]) {
+          seen[n] = 1 ;
+          order[tail++] = rank[n] ;
+        }
+      }
+
+      /* visit the new neighbors by increasing degree, ties by id */
+      qsort(order + first, tail - first, sizeof(u32_t), _map_comp_u32) ;
+
+      for (usiz_t i = first ; i < tail ; ++i)
+        order[i] = by_rank[order[i]] ;
+    }
+  }
+
+  for (usiz_t i = 0 ; i < n_terr / 2 ; ++i) {
+    u32_t tmp = order[i] ;
+
+    order[i] = order[n_terr - 1 - i] ;
+    order[n_terr - 1 - i] = tmp ;
+  }
+}
+
+_RIGE_API usiz_t map_reorder (map_t * map)
+{
+  if (RIGE_NULL == map || RIGE_NULL == map->adj_off || RIGE_NULL != map->to_old)
+    return RIGE_NPOS ;
+
+  usiz_t n_terr = map->n_terr ;
+  usiz_t n_adj  = map->adj_off[n_terr] ;
+
+  u32_t * to_old  = (u32_t *)mem_alloc(n_terr * sizeof(u32_t)) ;
+  u32_t * to_new  = (u32_t *)mem_alloc(n_terr * sizeof(u32_t)) ;
+  u32_t * adj_off = (u32_t *)mem_alloc((n_terr + 1) * sizeof(u32_t)) ;
+  u32_t * adj     = (u32_t *)mem_alloc(n_adj * sizeof(u32_t)) ;
+  u8_t *  seen    = (u8_t *)mem_alloc(n_terr) ;
+
+  if (RIGE_NULL == to_old || RIGE_NULL == to_new || RIGE_NULL == adj_off || (0 != n_adj && RIGE_NULL == adj) || RIGE_NULL == seen) {
+    mem_dealloc(to_old) ;
+    mem_dealloc(to_new) ;
+    mem_dealloc(adj_off) ;
+    mem_dealloc(adj) ;
+    mem_dealloc(seen) ;
+
+    return RIGE_NPOS ;
+  }
+
+  /* neighbors end up with close ids, so iterating over the borders of a
+   * territory touches few cache lines of the per-territory arrays
+   */
+  _map_rcm(map, to_old, seen, adj_off, to_new) ;
+
+  for (u32_t t = 0 ; t < n_terr ; ++t)
+    to_new[to_old[t]] = t ;
+
+  adj_off[0] = 0 ;
+
+  for (u32_t t = 0 ; t < n_terr ; ++t) {
+    u32_t old = to_old[t] ;
+    u32_t size = adj_off[t] ;
+
+    for (u32_t i = map->adj_off[old] ; i < map->adj_off[old + 1] ; ++i)
+      adj[size++] = to_new[map->adj[i]] ;
+
+    /* keep every list sorted, scans then walk memory forward */
+    qsort(adj + adj_off[t], size - adj_off[t], sizeof(u32_t), _map_comp_u32) ;
+
+    adj_off[t + 1] = size ;
+  }
+
+  mem_dealloc(map->adj_off) ;
+  mem_dealloc(map->adj) ;
+  mem_dealloc(seen) ;
+
+  map->adj_off = adj_off ;
+  map->adj     = adj ;
+  map->to_old  = to_old ;
+  map->to_new  = to_new ;
+
+  /* the continents follow their territories */
+  if (RIGE_NULL != map->cont && RIGE_NPOS == map_permute(map, map->cont, sizeof(u32_t)))
+    return RIGE_NPOS ;
+
+  if (RIGE_NULL != map->cells) {
+    for (usiz_t i = 0 ; i < (usiz_t)map->size.x * map->size.y ; ++i)
+      map->cells[i] = to_new[map->cells[i]] ;
+  }
+
+  ++map->epoch ;
+
+  return n_terr ;
+}
+
+_RIGE_API usiz_t map_permute (const map_t * map, ptr_t _ptr, usiz_t elem_size)
+{
+  u8_t * ptr = (u8_t *)_ptr ;
+
+  if (RIGE_NULL == map || RIGE_NULL == ptr || 0 == elem_size)
+    return RIGE_NPOS ;
+
+  /* not reordered, nothing to do */
+  if (RIGE_NULL == map->to_old)
+    return map->n_terr ;
+
+  /* moves a per-territory array from the file order to the map order */
+  u8_t * tmp = (u8_t *)mem_alloc(map->n_terr * elem_size) ;
+
+  if (RIGE_NULL == tmp)
+    return RIGE_NPOS ;
+
+  for (usiz_t t = 0 ; t < map->n_terr ; ++t)
+    mem_copy(tmp + t * elem_size, ptr + map->to_old[t] * elem_size, elem_size) ;
+
+  mem_copy(ptr, tmp, map->n_terr * elem_size) ;
+  mem_dealloc(tmp) ;
+
+  return map->n_terr ;
+}
+
+_RIGE_API u32_t map_to_old (const map_t * map, u32_t terr)
+{
+  if (RIGE_NULL == map || RIGE_NULL == map->to_old || map->n_terr <= terr)
+    return terr ;
+
+  return map->to_old[terr] ;
+}
+
+_RIGE_API u32_t map_to_new (const map_t * map, u32_t terr)
+{
+  if (RIGE_NULL == map || RIGE_NULL == map->to_new || map->n_terr <= terr)
+    return terr ;
+
+  return map->to_new[terr] ;
+}
+
+_RIGE_API usiz_t map_attacks (const map_t * map, const u8_t * owner, const u32_t * armies, u8_t player, u32_t * moves, usiz_t n)
+{
+  if (RIGE_NULL == map || RIGE_NULL == owner || RIGE_NULL == armies || RIGE_NULL == moves)
+    return RIGE_NPOS ;
+
+  /* the generic version of `bset*_attacks`, `moves` gets (from, to) pairs
+   * for every territory of `player` that can attack a neighbor
+   */
+  usiz_t size = 0 ;
+
+  RIGE_PROF_BEGIN(PROF_MOVEGEN) ;
+
+  for (u32_t t = 0 ; t < map->n_terr && size < n ; ++t) {
+    if (player != owner[t] || armies[t] < 2)
+      continue ;
+
+    for (u32_t i = map->adj_off[t] ; i < map->adj_off[t + 1] && size < n ; ++i) {
+      u32_t e = map->adj[i] ;
+
+      if (player == owner[e])
+        continue ;
+
+      moves[2 * size + 0] = t ;
+      moves[2 * size + 1] = e ;
+      ++size ;
+    }
+  }
+
+  RIGE_PROF_END(PROF_MOVEGEN) ;
+
+  return size ;
+}
+
+#undef _map_degree
+
+/* ----------------------------------------------------------------
+ * dist
+ */
+
+typedef struct _dist_job_s _dist_job_t ;
+
+/* the rows of `dist` to fill, from the territories in `from` or from
+ * every territory when it is `RIGE_NULL`
+ */
+struct _dist_job_s {
+  const map_t *  map    ;
+  dist_t *       dist   ;
+  const u32_t *  from   ;
+  usiz_t         n_rows ;
+  _Atomic usiz_t next   ;
+} ;
+
+/* breadth-first search from `from`, writes one row of `n_terr` distances */
+static void _dist_bfs (const map_t * map, u32_t from, u8_t * row, u32_t * queue)
+{
+  mem_set(row, DIST_INF, map->n_terr) ;
+
+  usiz_t head = 0 ;
+  usiz_t tail = 0 ;
+
+  row[from] = 0 ;
+  queue[tail++] = from ;
+
+  while (head < tail) {
+    u32_t t = queue[head++] ;
+
+    /* farther territories stay at `DIST_INF` */
+    if (DIST_INF - 1 <= row[t])
+      continue ;
+
+    for (u32_t i = map->adj_off[t] ; i < map->adj_off[t + 1] ; ++i) {
+      u32_t n = map->adj[i] ;
+
+      if (DIST_INF == row[n]) {
+        row[n] = row[t] + 1 ;
+        queue[tail++] = n ;
+      }
+    }
+  }
+}
+
+/* lowers `best` to the distances from `from`, up to `depth` hops. `row`
+ * is all `DIST_INF` and is left so, only the territories reached are
+ * touched
+ */
+static void _dist_lower (const map_t * map, u32_t from, u8_t depth, u8_t * best, u8_t * row, u32_t * queue)
+{
+  usiz_t head = 0 ;
+  usiz_t tail = 0 ;
+
+  row[from] = 0 ;
+  queue[tail++] = from ;
+
+  while (head < tail) {
+    u32_t t = queue[head++] ;
+
+    if (row[t] < best[t]) {
+      best[t] = row[t] ;
+    }
+
+    if (depth <= row[t])
+      continue ;
+
+    for (u32_t i = map->adj_off[t] ; i < map->adj_off[t + 1] ; ++i) {
+      u32_t n = map->adj[i] ;
+
+      if (DIST_INF == row[n]) {
+        row[n] = row[t] + 1 ;
+        queue[tail++] = n ;
+      }
+    }
+  }
+
+  for (usiz_t i = 0 ; i < tail ; ++i)
+    row[queue[i]] = DIST_INF ;
+}
+
+static void * _dist_worker (void * arg)
+{
+  _dist_job_t * job = (_dist_job_t *)arg ;
+  usiz_t n_terr = job->map->n_terr ;
+  u32_t * queue = (u32_t *)mem_alloc(n_terr * sizeof(u32_t)) ;
+
+  if (RIGE_NULL == queue)
+    return RIGE_NULL ;
+
+  /* rows are handed out in small blocks to balance the threads */
+  for (;;) {
+    usiz_t first = atomic_fetch_add(&job->next, 16) ;
+
+    if (job->n_rows <= first)
+      break ;
+
+    for (usiz_t r = first ; r < first + 16 && r < job->n_rows ; ++r) {
+      u32_t from = RIGE_NULL == job->from ? (u32_t)r : job->from[r] ;
+
+      _dist_bfs(job->map, from, job->dist->data + r * n_terr, queue) ;
+    }
+  }
+
+  mem_dealloc(queue) ;
+
+  return RIGE_NULL ;
+}
+
+/* one breadth-first search per row, on `n_threads` threads */
+static usiz_t _dist_rows (dist_t * dist, const map_t * map, const u32_t * from, usiz_t n_rows, usiz_t n_threads)
+{
+  if (0 == n_threads) {
+    long n_cpus = sysconf(_SC_NPROCESSORS_ONLN) ;
+
+    n_threads = n_cpus < 1 ? 1 : (usiz_t)n_cpus ;
+  }
+
+  if (64 < n_threads) {
+    n_threads = 64 ;
+  }
+
+  /* more threads than blocks of rows would only be started and joined */
+  if ((n_rows + 15) / 16 < n_threads) {
+    n_threads = (n_rows + 15) / 16 ;
+  }
+
+  _dist_job_t job ;
+  pthread_t threads [64] ;
+  usiz_t n_started ;
+
+  job.map    = map ;
+  job.dist   = dist ;
+  job.from   = from ;
+  job.n_rows = n_rows ;
+  atomic_init(&job.next, 0) ;
+
+  /* the calling thread works too */
+  for (n_started = 0 ; n_started + 1 < n_threads ; ++n_started) {
+    if (0 != pthread_create(&threads[n_started], RIGE_NULL, _dist_worker, &job))
+      break ;
+  }
+
+  _dist_worker(&job) ;
+
+  for (usiz_t i = 0 ; i < n_started ; ++i)
+    pthread_join(threads[i], RIGE_NULL) ;
+
+  /* no thread could get its queue, the rows were never filled */
+  if (atomic_load(&job.next) < n_rows)
+    return RIGE_NPOS ;
+
+  return n_rows ;
+}
+
+static usiz_t _dist_build_land (dist_t * dist, const map_t * map, usiz_t n_land, usiz_t n_threads)
+{
+  usiz_t n_terr = map->n_terr ;
+
+  dist->n_land = n_land ;
+  dist->land   = (u32_t *)mem_alloc(n_land * sizeof(u32_t)) ;
+  dist->data   = (u8_t *)mem_alloc(n_land * n_terr) ;
+
+  u32_t * queue = (u32_t *)mem_alloc(n_terr * sizeof(u32_t)) ;
+  u8_t * best = (u8_t *)mem_alloc(n_terr) ;
+  u8_t * row = (u8_t *)mem_alloc(n_terr) ;
+
+  if (RIGE_NULL == dist->land || RIGE_NULL == dist->data || RIGE_NULL == queue || RIGE_NULL == best || RIGE_NULL == row) {
+    mem_dealloc(queue) ;
+    mem_dealloc(best) ;
+    mem_dealloc(row) ;
+    dist_free(dist) ;
+
+    return RIGE_NPOS ;
+  }
+
+  /* farthest-point sampling, every landmark is the territory farthest from
+   * all the previous ones. `best` is the distance to the nearest landmark.
+   * a new landmark only lowers `best` closer than `best[next]`, the
+   * largest of all, so the search stops there and the full rows are left
+   * to the threads
+   */
+  mem_set(best, DIST_INF, n_terr) ;
+  mem_set(row, DIST_INF, n_terr) ;
+
+  u32_t next = 0 ;
+
+  for (usiz_t l = 0 ; l < n_land ; ++l) {
+    u8_t depth = best[next] < DIST_INF - 1 ? best[next] : DIST_INF - 1 ;
+
+    dist->land[l] = next ;
+    _dist_lower(map, next, depth, best, row, queue) ;
+
+    /* only once `best` is complete, during the update `best[next]` still
+     * holds the previous maximum and `next` would never move
+     */
+    u8_t max = 0 ;
+
+    for (usiz_t t = 0 ; t < n_terr ; ++t) {
+      if (max < best[t]) {
+        max  = best[t] ;
+        next = t ;
+      }
+    }
+  }
+
+  mem_dealloc(queue) ;
+  mem_dealloc(best) ;
+  mem_dealloc(row) ;
+
+  if (RIGE_NPOS == _dist_rows(dist, map, dist->land, n_land, n_threads)) {
+    dist_free(dist) ;
+    return RIGE_NPOS ;
+  }
+
+  return n_terr ;
+}
+
+_RIGE_API usiz_t dist_build (dist_t * dist, const map_t * map, usiz_t max_bytes, usiz_t n_threads)
+{
+  if (RIGE_NULL == dist || RIGE_NULL == map || 0 == map->n_terr)
+    return RIGE_NPOS ;
+
+  usiz_t n_terr = map->n_terr ;
+
+  dist->n_terr = n_terr ;
+  dist->n_land = 0 ;
+  dist->land   = RIGE_NULL ;
+  dist->data   = RIGE_NULL ;
+
+  /* too large for the full matrix, keep some landmark rows instead */
+  if (max_bytes / n_terr < n_terr) {
+    usiz_t n_land = max_bytes / n_terr ;
+
+    if (0 == n_land)
+      return RIGE_NPOS ;
+
+    return _dist_build_land(dist, map, n_land < n_terr ? n_land : n_terr, n_threads) ;
+  }
+
+  dist->data = (u8_t *)mem_alloc(n_terr * n_terr) ;
+
+  if (RIGE_NULL == dist->data)
+    return RIGE_NPOS ;
+
+  if (RIGE_NPOS == _dist_rows(dist, map, RIGE_NULL, n_terr, n_threads)) {
+    dist_free(dist) ;
+    return RIGE_NPOS ;
+  }
+
+  return n_terr ;
+}
+
+_RIGE_API void dist_free (dist_t * dist)
+{
+  if (RIGE_NULL == dist)
+    return ;
+
+  mem_dealloc(dist->land) ;
+  mem_dealloc(dist->data) ;
+
+  dist->n_terr = 0 ;
+  dist->n_land = 0 ;
+  dist->land   = RIGE_NULL ;
+  dist->data   = RIGE_NULL ;
+}
+
+_RIGE_API u32_t dist_get (const dist_t * dist, u32_t from, u32_t to)
+{
+  if (RIGE_NULL == dist || RIGE_NULL == dist->data || dist->n_terr <= from || dist->n_terr <= to)
+    return DIST_INF ;
+
+  if (0 == dist->n_land)
+    return dist->data[from * dist->n_terr + to] ;
+
+  if (from == to)
+    return 0 ;
+
+  /* upper bound through the best landmark, exact when either end is one.
+   * the sum of two rows can pass `DIST_INF`, `best` starts there to clamp
+   */
+  u32_t best = DIST_INF ;
+
+  for (usiz_t l = 0 ; l < dist->n_land ; ++l) {
+    const u8_t * row = dist->data + l * dist->n_terr ;
+    u32_t hops = row[from] + row[to] ;
+
+    if (hops < best) {
+      best = hops ;
+    }
+  }
+
+  return best ;
+}
+
+_RIGE_API u32_t dist_nearest (const dist_t * dist, u32_t from, const u32_t * set, usiz_t n)
+{
+  if (RIGE_NULL == set)
+    return (u32_t)RIGE_NPOS ;
+
+  /* e.g. "nearest enemy border" with `set` being the enemy territories */
+  u32_t best = (u32_t)RIGE_NPOS ;
+  u32_t best_hops = DIST_INF + 1 ;
+
+  for (usiz_t i = 0 ; i < n ; ++i) {
+    u32_t hops = dist_get(dist, from, set[i]) ;
+
+    if (hops < best_hops) {
+      best      = set[i] ;
+      best_hops = hops ;
+    }
+  }
+
+  return best ;
+}
+
+#define _DIST_MAGIC   0x54444952 /* "RIDT" */
+#define _DIST_VERSION 1
+
+/* the cache file next to the map: magic, version, map hash, `n_terr`,
+ * `n_land`, the landmarks and the rows
+ */
+static usiz_t _dist_save (const dist_t * dist, const cstr_t path, u32_t hash)
+{
+  if (RIGE_NULL == dist || RIGE_NULL == dist->data || RIGE_NULL == path)
+    return RIGE_NPOS ;
+
+  FILE * file = fopen(path, "wb") ;
+
+  if (RIGE_NULL == file)
+    return RIGE_NPOS ;
+
+  u32_t head [3] = { _DIST_MAGIC , _DIST_VERSION , hash } ;
+  u64_t size [2] = { dist->n_terr , dist->n_land } ;
+  usiz_t n_rows = 0 == dist->n_land ? dist->n_terr : dist->n_land ;
+  usiz_t ok = 1 ;
+
+  ok = ok && 3 == fwrite(head, sizeof(u32_t), 3, file) ;
+  ok = ok && 2 == fwrite(size, sizeof(u64_t), 2, file) ;
+  ok = ok && (0 == dist->n_land || dist->n_land == fwrite(dist->land, sizeof(u32_t), dist->n_land, file)) ;
+  ok = ok && n_rows == fwrite(dist->data, dist->n_terr, n_rows, file) ;
+
+  if (0 != fclose(file) || 0 == ok)
+    return RIGE_NPOS ;
+
+  return dist->n_terr ;
+}
+
+_RIGE_API usiz_t dist_save (const dist_t * dist, const cstr_t path, u32_t hash)
+{
+  RIGE_PROF_BEGIN(PROF_IO) ;
+
+  usiz_t retval = _dist_save(dist, path, hash) ;
+
+  RIGE_PROF_END(PROF_IO) ;
+
+  return retval ;
+}
+
+static usiz_t _dist_load (dist_t * dist, const cstr_t path, u32_t hash)
+{
+  if (RIGE_NULL == dist || RIGE_NULL == path)
+    return RIGE_NPOS ;
+
+  FILE * file = fopen(path, "rb") ;
+
+  if (RIGE_NULL == file)
+    return RIGE_NPOS ;
+
+  u32_t head [3] ;
+  u64_t size [2] ;
+
+  dist->n_terr = 0 ;
+  dist->n_land = 0 ;
+  dist->land   = RIGE_NULL ;
+  dist->data   = RIGE_NULL ;
+
+  /* a cache built for another map or by another version is stale */
+  if (
+    3 != fread(head, sizeof(u32_t), 3, file) ||
+    2 != fread(size, sizeof(u64_t), 2, file) ||
+    _DIST_MAGIC != head[0] || _DIST_VERSION != head[1] || hash != head[2] ||
+    0 == size[0] || size[0] < size[1] || (u32_t)RIGE_NPOS < size[0]
+  ) {
+    fclose(file) ;
+    return RIGE_NPOS ;
+  }
+
+  usiz_t n_rows = 0 == size[1] ? size[0] : size[1] ;
+
+  /* the sizes are not trusted before the rest of the file matches them,
+   * a damaged header must not allocate or read beyond it
+   */
+  long here = ftell(file) ;
+  long end  = 0 == fseek(file, 0, SEEK_END) ? ftell(file) : -1 ;
+
+  if (
+    here < 0 || end < here || 0 != fseek(file, here, SEEK_SET) ||
+    RIGE_NPOS / size[0] < n_rows ||
+    (usiz_t)(end - here) / sizeof(u32_t) < size[1] ||
+    (usiz_t)(end - here) - size[1] * sizeof(u32_t) != n_rows * size[0]
+  ) {
+    fclose(file) ;
+    return RIGE_NPOS ;
+  }
+
+  dist->n_terr = size[0] ;
+  dist->n_land = size[1] ;
+  dist->data   = (u8_t *)mem_alloc(n_rows * dist->n_terr) ;
+
+  if (0 != dist->n_land) {
+    dist->land = (u32_t *)mem_alloc(dist->n_land * sizeof(u32_t)) ;
+  }
+
+  if (
+    RIGE_NULL == dist->data || (0 != dist->n_land && RIGE_NULL == dist->land) ||
+    (0 != dist->n_land && dist->n_land != fread(dist->land, sizeof(u32_t), dist->n_land, file)) ||
+    n_rows != fread(dist->data, dist->n_terr, n_rows, file)
+  ) {
+    fclose(file) ;
+    dist_free(dist) ;
+
+    return RIGE_NPOS ;
+  }
+
+  fclose(file) ;
+
+  return dist->n_terr ;
+}
+
+_RIGE_API usiz_t dist_load (dist_t * dist, const cstr_t path, u32_t hash)
+{
+  RIGE_PROF_BEGIN(PROF_IO) ;
+
+  usiz_t retval = _dist_load(dist, path, hash) ;
+
+  RIGE_PROF_END(PROF_IO) ;
+
+  return retval ;
+}
+
+_RIGE_API usiz_t dist_cache (dist_t * dist, const map_t * map, const cstr_t map_path, usiz_t max_bytes, usiz_t n_threads)
+{
+  if (RIGE_NULL == dist || RIGE_NULL == map || RIGE_NULL == map_path || 0 == map->n_terr)
+    return RIGE_NPOS ;
+
+  strbuf_t path ;
+
+  strbuf_init(&path) ;
+
+  if (RIGE_NPOS == strbuf_append(&path, map_path) || RIGE_NPOS == strbuf_append(&path, ".dist")) {
+    strbuf_free(&path) ;
+    return RIGE_NPOS ;
+  }
+
+  /* a cache of another shape was built with another budget */
+  usiz_t n_terr = map->n_terr ;
+  usiz_t n_land = max_bytes / n_terr < n_terr ? max_bytes / n_terr : 0 ;
+  u32_t hash = map_hash(map) ;
+
+  if (RIGE_NPOS != dist_load(dist, path.data, hash)) {
+    if (n_terr == dist->n_terr && n_land == dist->n_land) {
+      strbuf_free(&path) ;
+      return n_terr ;
+    }
+
+    dist_free(dist) ;
+  }
+
+  if (RIGE_NPOS == dist_build(dist, map, max_bytes, n_threads)) {
+    strbuf_free(&path) ;
+    return RIGE_NPOS ;
+  }
+
+  /* the table is good without its cache, e.g. next to a read-only map */
+  dist_save(dist, path.data, hash) ;
+  strbuf_free(&path) ;
+
+  return n_terr ;
+}
+
+#undef _DIST_MAGIC
+#undef _DIST_VERSION
+
+/* ----------------------------------------------------------------
+ * dset
+ */
+
+#define _DSET_MAGIC   0x53444952 /* "RIDS" */
+#define _DSET_VERSION 2
+
+static u32_t _crc32_tab [256] ;
+static pthread_once_t _crc32_once = PTHREAD_ONCE_INIT ;
+
+static void _crc32_init (void)
+{
+  for (u32_t i = 0 ; i < 256 ; ++i) {
+    u32_t crc = i ;
+
+    for (i32_t k = 0 ; k < 8 ; ++k)
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1))) ;
+
+    _crc32_tab[i] = crc ;
+  }
+}
+
+_RIGE_API u32_t mem_crc32 (const ptr_t _ptr, usiz_t n)
+{
+  u8_t * ptr = (u8_t *)_ptr ;
+
+  if (RIGE_NULL == ptr)
+    return 0 ;
+
+  pthread_once(&_crc32_once, _crc32_init) ;
+
+  /* same as zlib's `crc32` */
+  u32_t crc = 0xFFFFFFFF ;
+
+  for (usiz_t size = 0 ; size < n ; ++size)
+    crc = (crc >> 8) ^ _crc32_tab[(crc ^ ptr[size]) & 0xFF] ;
+
+  return ~crc ;
+}
+
+/* one chunk: magic, version, `n_cols`, checksum of the payload, `n_rows`
+ * and the payload size, then every column in turn
+ */
+static i32_t _dset_write (dset_t * ds, f32_t * buf, usiz_t rows)
+{
+  usiz_t col_size = rows * sizeof(f32_t) ;
+
+  /* compact a partial chunk so the columns are contiguous */
+  if (rows < ds->chunk_rows) {
+    for (usiz_t c = 1 ; c < ds->n_cols ; ++c)
+      mem_copy(buf + c * rows, buf + c * ds->chunk_rows, col_size) ;
+  }
+
+  u64_t size [2] = { rows , ds->n_cols * col_size } ;
+  u32_t head [4] = { _DSET_MAGIC , _DSET_VERSION , (u32_t)ds->n_cols , mem_crc32(buf, size[1]) } ;
+
+  if (4 != fwrite(head, sizeof(u32_t), 4, ds->file) || 2 != fwrite(size, sizeof(u64_t), 2, ds->file))
+    return -1 ;
+
+  if (size[1] != fwrite(buf, 1, size[1], ds->file))
+    return -1 ;
+
+  return 0 ;
+}
+
+static void * _dset_writer (void * arg)
+{
+  dset_t * ds = (dset_t *)arg ;
+
+  pthread_mutex_lock(&ds->lock) ;
+
+  for (;;) {
+    while (0 == ds->pending && 0 == ds->done)
+      pthread_cond_wait(&ds->cond, &ds->lock) ;
+
+    if (0 == ds->pending)
+      break ;
+
+    /* the full buffer is the one not being filled */
+    f32_t * buf = ds->buf[1 - ds->fill] ;
+    usiz_t rows = ds->pending ;
+
+    /* after a failed write the file is cut short, later chunks would only
+     * hide where
+     */
+    pthread_mutex_unlock(&ds->lock) ;
+    i32_t error = 0 != atomic_load(&ds->error) ? -1 : _dset_write(ds, buf, rows) ;
+    pthread_mutex_lock(&ds->lock) ;
+
+    atomic_fetch_or(&ds->error, error) ;
+    ds->pending = 0 ;
+    pthread_cond_broadcast(&ds->cond) ;
+  }
+
+  pthread_mutex_unlock(&ds->lock) ;
+
+  return RIGE_NULL ;
+}
+
+static void _dset_release (dset_t * ds)
+{
+  if (RIGE_NULL != ds->file) {
+    fclose(ds->file) ;
+  }
+
+  mem_dealloc(ds->buf[0]) ;
+  mem_dealloc(ds->buf[1]) ;
+
+  ds->file   = RIGE_NULL ;
+  ds->buf[0] = RIGE_NULL ;
+  ds->buf[1] = RIGE_NULL ;
+}
+
+_RIGE_API usiz_t dset_open (dset_t * ds, const cstr_t path, usiz_t n_cols, usiz_t chunk_rows)
+{
+  if (RIGE_NULL == ds || RIGE_NULL == path || 0 == n_cols || (u32_t)RIGE_NPOS < n_cols || 0 == chunk_rows)
+    return RIGE_NPOS ;
+
+  ds->n_cols     = n_cols ;
+  ds->chunk_rows = chunk_rows ;
+  ds->fill       = 0 ;
+  ds->rows       = 0 ;
+  ds->pending    = 0 ;
+  ds->total      = 0 ;
+  ds->done       = 0 ;
+  ds->buf[0]     = (f32_t *)mem_alloc(n_cols * chunk_rows * sizeof(f32_t)) ;
+  ds->buf[1]     = (f32_t *)mem_alloc(n_cols * chunk_rows * sizeof(f32_t)) ;
+  ds->file       = fopen(path, "wb") ;
+
+  if (RIGE_NULL == ds->buf[0] || RIGE_NULL == ds->buf[1] || RIGE_NULL == ds->file) {
+    _dset_release(ds) ;
+    return RIGE_NPOS ;
+  }
+
+  atomic_init(&ds->error, 0) ;
+  pthread_mutex_init(&ds->lock, RIGE_NULL) ;
+  pthread_cond_init(&ds->cond, RIGE_NULL) ;
+
+  if (0 != pthread_create(&ds->thread, RIGE_NULL, _dset_writer, ds)) {
+    pthread_mutex_destroy(&ds->lock) ;
+    pthread_cond_destroy(&ds->cond) ;
+    _dset_release(ds) ;
+
+    return RIGE_NPOS ;
+  }
+
+  return n_cols ;
+}
+
+/* hand the filling buffer to the writer and swap */
+static void _dset_flush (dset_t * ds)
+{
+  pthread_mutex_lock(&ds->lock) ;
+
+  /* only waits when the disk is slower than the simulation */
+  while (0 != ds->pending)
+    pthread_cond_wait(&ds->cond, &ds->lock) ;
+
+  ds->pending = ds->rows ;
+  ds->fill    = 1 - ds->fill ;
+  ds->rows    = 0 ;
+
+  pthread_cond_broadcast(&ds->cond) ;
+  pthread_mutex_unlock(&ds->lock) ;
+}
+
+_RIGE_API usiz_t dset_push (dset_t * ds, const f32_t * row)
+{
+  if (RIGE_NULL == ds || RIGE_NULL == ds->file || RIGE_NULL == row)
+    return RIGE_NPOS ;
+
+  /* the writer failed on an earlier chunk, the rows from there on are lost */
+  if (0 != atomic_load_explicit(&ds->error, memory_order_relaxed))
+    return RIGE_NPOS ;
+
+  f32_t * buf = ds->buf[ds->fill] ;
+
+  for (usiz_t c = 0 ; c < ds->n_cols ; ++c)
+    buf[c * ds->chunk_rows + ds->rows] = row[c] ;
+
+  /* the index of the row in the file */
+  usiz_t index = ds->total++ ;
+
+  if (ds->chunk_rows == ++ds->rows) {
+    _dset_flush(ds) ;
+  }
+
+  return index ;
+}
+
+_RIGE_API u64_t dset_close (dset_t * ds)
+{
+  if (RIGE_NULL == ds || RIGE_NULL == ds->file)
+    return (u64_t)RIGE_NPOS ;
+
+  if (0 != ds->rows) {
+    _dset_flush(ds) ;
+  }
+
+  pthread_mutex_lock(&ds->lock) ;
+  ds->done = 1 ;
+  pthread_cond_broadcast(&ds->cond) ;
+  pthread_mutex_unlock(&ds->lock) ;
+
+  pthread_join(ds->thread, RIGE_NULL) ;
+  pthread_mutex_destroy(&ds->lock) ;
+  pthread_cond_destroy(&ds->cond) ;
+
+  i32_t error = atomic_load(&ds->error) | (0 != fclose(ds->file)) ;
+
+  ds->file = RIGE_NULL ;
+  _dset_release(ds) ;
+
+  if (0 != error)
+    return (u64_t)RIGE_NPOS ;
+
+  return ds->total ;
+}
+
+_RIGE_API usiz_t dset_chunk (const ptr_t _ptr, usiz_t n, u32_t * n_cols, u64_t * n_rows)
+{
+  u8_t * ptr = (u8_t *)_ptr ;
+
+  if (RIGE_NULL == ptr || n < DSET_HEAD_SIZE)
+    return RIGE_NPOS ;
+
+  /* meant for a `mmap`ed file: check the chunk at `ptr` and return its
+   * size, the columns start at `ptr + DSET_HEAD_SIZE`
+   */
+  u32_t head [4] ;
+  u64_t size [2] ;
+
+  mem_copy(head, ptr, sizeof(head)) ;
+  mem_copy(size, ptr + sizeof(head), sizeof(size)) ;
+
+  if (_DSET_MAGIC != head[0] || _DSET_VERSION != head[1] || 0 == head[2])
+    return RIGE_NPOS ;
+
+  /* `n_cols * n_rows` could wrap, the payload size is divided instead */
+  u64_t row_size = (u64_t)head[2] * sizeof(f32_t) ;
+
+  if (0 != size[1] % row_size || size[1] / row_size != size[0] || n - DSET_HEAD_SIZE < size[1])
+    return RIGE_NPOS ;
+
+  if (head[3] != mem_crc32(ptr + DSET_HEAD_SIZE, size[1]))
+    return RIGE_NPOS ;
+
+  if (RIGE_NULL != n_cols) {
+    *n_cols = head[2] ;
+  }
+
+  if (RIGE_NULL != n_rows) {
+    *n_rows = size[0] ;
+  }
+
+  return DSET_HEAD_SIZE + size[1] ;
+}
+
+#undef _DSET_MAGIC
+#undef _DSET_VERSION
+
+/* ----------------------------------------------------------------
+ * bits
+ */
+
+_RIGE_API u64_t bits_get (const u64_t * words, usiz_t pos, u32_t width)
+{
+  if (RIGE_NULL == words || 0 == width || 64 < width)
+    return 0 ;
+
+  usiz_t word  = pos >> 6 ;
+  u32_t  shift = pos & 63 ;
+  u64_t  mask  = 64 == width ? ~(u64_t)0 : ((u64_t)1 << width) - 1 ;
+  u64_t  val   = words[word] >> shift ;
+
+  /* the field straddles two words */
+  if (64 < shift + width) {
+    val |= words[word + 1] << (64 - shift) ;
+  }
+
+  return val & mask ;
+}
+
+_RIGE_API void bits_set (u64_t * words, usiz_t pos, u32_t width, u64_t val)
+{
+  if (RIGE_NULL == words || 0 == width || 64 < width)
+    return ;
+
+  usiz_t word  = pos >> 6 ;
+  u32_t  shift = pos & 63 ;
+  u64_t  mask  = 64 == width ? ~(u64_t)0 : ((u64_t)1 << width) - 1 ;
+
+  val &= mask ;
+
+  words[word] = (words[word] & ~(mask << shift)) | (val << shift) ;
+
+  if (64 < shift + width) {
+    words[word + 1] = (words[word + 1] & ~(mask >> (64 - shift))) | (val >> (64 - shift)) ;
+  }
+}
+
+/* ----------------------------------------------------------------
+ * pool
+ */
+
+#define _POOL_OWNER_BITS 3
+#define _POOL_BUCKET_BITS 2
+
+/* bucket `b` stores armies from `base` with `width` bits */
+static const u32_t _pool_bucket_base  [4] = { 0 , 4 , 20 , 276 } ;
+static const u32_t _pool_bucket_width [4] = { 2 , 4 ,  8 ,  32 } ;
+
+static u32_t _pool_bucket (u32_t armies)
+{
+  if (armies < _pool_bucket_base[1])
+    return 0 ;
+
+  if (armies < _pool_bucket_base[2])
+    return 1 ;
+
+  if (armies < _pool_bucket_base[3])
+    return 2 ;
+
+  return 3 ;
+}
+
+static usiz_t _pool_bits (const pool_t * pool, const u32_t * armies)
+{
+  usiz_t bits = pool->n_terr * (_POOL_OWNER_BITS + _POOL_BUCKET_BITS) + pool->n_players * pool->n_cards ;
+
+  for (usiz_t t = 0 ; t < pool->n_terr ; ++t)
+    bits += _pool_bucket_width[_pool_bucket(armies[t])] ;
+
+  return bits ;
+}
+
+static void _pool_encode (const pool_t * pool, u64_t * words, const u8_t * owner, const u32_t * armies, const u64_t * cards)
+{
+  usiz_t pos = 0 ;
+
+  for (usiz_t t = 0 ; t < pool->n_terr ; ++t) {
+    u32_t bucket = _pool_bucket(armies[t]) ;
+
+    bits_set(words, pos, _POOL_OWNER_BITS + _POOL_BUCKET_BITS, owner[t] | (bucket << _POOL_OWNER_BITS)) ;
+    pos += _POOL_OWNER_BITS + _POOL_BUCKET_BITS ;
+
+    bits_set(words, pos, _pool_bucket_width[bucket], armies[t] - _pool_bucket_base[bucket]) ;
+    pos += _pool_bucket_width[bucket] ;
+  }
+
+  if (0 == pool->n_cards)
+    return ;
+
+  for (usiz_t p = 0 ; p < pool->n_players ; ++p) {
+    bits_set(words, pos, pool->n_cards, cards[p]) ;
+    pos += pool->n_cards ;
+  }
+}
+
+static void _pool_decode (const pool_t * pool, const u64_t * words, u8_t * owner, u32_t * armies, u64_t * cards)
+{
+  usiz_t pos = 0 ;
+
+  for (usiz_t t = 0 ; t < pool->n_terr ; ++t) {
+    u32_t head = bits_get(words, pos, _POOL_OWNER_BITS + _POOL_BUCKET_BITS) ;
+    u32_t bucket = head >> _POOL_OWNER_BITS ;
+
+    pos += _POOL_OWNER_BITS + _POOL_BUCKET_BITS ;
+
+    owner[t]  = head & ((1 << _POOL_OWNER_BITS) - 1) ;
+    armies[t] = _pool_bucket_base[bucket] + bits_get(words, pos, _pool_bucket_width[bucket]) ;
+    pos += _pool_bucket_width[bucket] ;
+  }
+
+  if (0 == pool->n_cards || RIGE_NULL == cards)
+    return ;
+
+  for (usiz_t p = 0 ; p < pool->n_players ; ++p) {
+    cards[p] = bits_get(words, pos, pool->n_cards) ;
+    pos += pool->n_cards ;
+  }
+}
+
+_RIGE_API usiz_t pool_init (pool_t * pool, usiz_t n_terr, usiz_t n_players, usiz_t n_cards)
+{
+  if (RIGE_NULL == pool)
+    return RIGE_NPOS ;
+
+  /* everything is set before the first failure, `pool_free` is always safe */
+  pool->n_terr     = n_terr ;
+  pool->n_players  = n_players ;
+  pool->n_cards    = n_cards ;
+  pool->max_words  = 0 ;
+  pool->slab       = RIGE_NULL ;
+  pool->slab_used  = RIGE_NULL ;
+  pool->slab_cap   = RIGE_NULL ;
+  pool->slab_free  = RIGE_NULL ;
+  pool->slab_nfree = RIGE_NULL ;
+  pool->ent_slot   = RIGE_NULL ;
+  pool->ent_gen    = RIGE_NULL ;
+  pool->ent_words  = RIGE_NULL ;
+  pool->ent_used   = 0 ;
+  pool->ent_cap    = 0 ;
+  pool->ent_free   = RIGE_NULL ;
+  pool->ent_nfree  = 0 ;
+  pool->n_states   = 0 ;
+
+  if (0 == n_terr || 0 == n_players || (1 << _POOL_OWNER_BITS) < n_players || 64 < n_cards)
+    return RIGE_NPOS ;
+
+  /* the largest state, every territory in the widest bucket. it must
+   * fit the `u8_t` size kept per handle, 0xFF means "not packed yet"
+   */
+  usiz_t max_words = (n_terr * (_POOL_OWNER_BITS + _POOL_BUCKET_BITS + 32) + n_players * n_cards + 63) / 64 ;
+
+  if (0xFF <= max_words)
+    return RIGE_NPOS ;
+
+  pool->max_words  = max_words ;
+  pool->slab       = (u64_t **)mem_calloc(max_words + 1, sizeof(u64_t *)) ;
+  pool->slab_used  = (usiz_t *)mem_calloc(max_words + 1, sizeof(usiz_t)) ;
+  pool->slab_cap   = (usiz_t *)mem_calloc(max_words + 1, sizeof(usiz_t)) ;
+  pool->slab_free  = (u32_t **)mem_calloc(max_words + 1, sizeof(u32_t *)) ;
+  pool->slab_nfree = (usiz_t *)mem_calloc(max_words + 1, sizeof(usiz_t)) ;
+
+  if (RIGE_NULL == pool->slab || RIGE_NULL == pool->slab_used || RIGE_NULL == pool->slab_cap || RIGE_NULL == pool->slab_free || RIGE_NULL == pool->slab_nfree) {
+    pool_free(pool) ;
+    return RIGE_NPOS ;
+  }
+
+  return max_words * sizeof(u64_t) ;
+}
+
+_RIGE_API void pool_free (pool_t * pool)
+{
+  if (RIGE_NULL == pool)
+    return ;
+
+  for (usiz_t w = 0 ; w <= pool->max_words ; ++w) {
+    if (RIGE_NULL != pool->slab) {
+      mem_dealloc(pool->slab[w]) ;
+    }
+
+    if (RIGE_NULL != pool->slab_free) {
+      mem_dealloc(pool->slab_free[w]) ;
+    }
+  }
+
+  mem_dealloc(pool->slab) ;
+  mem_dealloc(pool->slab_used) ;
+  mem_dealloc(pool->slab_cap) ;
+  mem_dealloc(pool->slab_free) ;
+  mem_dealloc(pool->slab_nfree) ;
+  mem_dealloc(pool->ent_slot) ;
+  mem_dealloc(pool->ent_gen) ;
+  mem_dealloc(pool->ent_words) ;
+  mem_dealloc(pool->ent_free) ;
+
+  pool->slab       = RIGE_NULL ;
+  pool->slab_used  = RIGE_NULL ;
+  pool->slab_cap   = RIGE_NULL ;
+  pool->slab_free  = RIGE_NULL ;
+  pool->slab_nfree = RIGE_NULL ;
+  pool->ent_slot   = RIGE_NULL ;
+  pool->ent_gen    = RIGE_NULL ;
+  pool->ent_words  = RIGE_NULL ;
+  pool->ent_free   = RIGE_NULL ;
+  pool->ent_used   = 0 ;
+  pool->ent_cap    = 0 ;
+  pool->ent_nfree  = 0 ;
+  pool->n_states   = 0 ;
+  pool->max_words  = 0 ;
+}
+
+/* a free slot in the slab of `words` words, `RIGE_NPOS` if out of memory */
+static usiz_t _pool_slot_new (pool_t * pool, usiz_t words)
+{
+  if (0 != pool->slab_nfree[words])
+    return pool->slab_free[words][--pool->slab_nfree[words]] ;
+
+  if (pool->slab_used[words] == pool->slab_cap[words]) {
+    usiz_t cap = 0 == pool->slab_cap[words] ? 64 : 2 * pool->slab_cap[words] ;
+    u64_t * slab = (u64_t *)mem_realloc(pool->slab[words], cap * words * sizeof(u64_t)) ;
+
+    if (RIGE_NULL == slab)
+      return RIGE_NPOS ;
+
+    pool->slab[words]     = slab ;
+    pool->slab_cap[words] = cap ;
+  }
+
+  return pool->slab_used[words]++ ;
+}
+
+static i32_t _pool_slot_del (pool_t * pool, usiz_t words, u32_t slot)
+{
+  usiz_t n = pool->slab_nfree[words] ;
+
+  /* the list doubles every time its size reaches a power of two */
+  if (0 == (n & (n - 1))) {
+    usiz_t cap = 0 == n ? 1 : 2 * n ;
+    u32_t * list = (u32_t *)mem_realloc(pool->slab_free[words], cap * sizeof(u32_t)) ;
+
+    if (RIGE_NULL == list)
+      return -1 ;
+
+    pool->slab_free[words] = list ;
+  }
+
+  pool->slab_free[words][pool->slab_nfree[words]++] = slot ;
+
+  return 0 ;
+}
+
+/* the entry of a live handle, `RIGE_NPOS` for a stale or bad one */
+static usiz_t _pool_entry (const pool_t * pool, handle_t h)
+{
+  usiz_t ent = (u32_t)h ;
+
+  if (pool->ent_used <= ent || 0 == pool->ent_words[ent] || pool->ent_gen[ent] != (u32_t)(h >> 32))
+    return RIGE_NPOS ;
+
+  return ent ;
+}
+
+_RIGE_API handle_t pool_put (pool_t * pool, const u8_t * owner, const u32_t * armies, const u64_t * cards)
+{
+  if (RIGE_NULL == pool || RIGE_NULL == owner || RIGE_NULL == armies || (0 != pool->n_cards && RIGE_NULL == cards))
+    return (handle_t)RIGE_NPOS ;
+
+  usiz_t ent ;
+
+  if (0 != pool->ent_nfree) {
+    ent = pool->ent_free[--pool->ent_nfree] ;
+  } else {
+    if (pool->ent_used == pool->ent_cap) {
+      usiz_t cap = 0 == pool->ent_cap ? 64 : 2 * pool->ent_cap ;
+      u32_t * slot = (u32_t *)mem_realloc(pool->ent_slot, cap * sizeof(u32_t)) ;
+
+      if (RIGE_NULL == slot)
+        return (handle_t)RIGE_NPOS ;
+
+      pool->ent_slot = slot ;
+
+      u32_t * gen = (u32_t *)mem_realloc(pool->ent_gen, cap * sizeof(u32_t)) ;
+
+      if (RIGE_NULL == gen)
+        return (handle_t)RIGE_NPOS ;
+
+      pool->ent_gen = gen ;
+
+      u8_t * words = (u8_t *)mem_realloc(pool->ent_words, cap * sizeof(u8_t)) ;
+
+      if (RIGE_NULL == words)
+        return (handle_t)RIGE_NPOS ;
+
+      pool->ent_words = words ;
+      pool->ent_cap   = cap ;
+    }
+
+    ent = pool->ent_used++ ;
+    pool->ent_gen[ent]   = 0 ;
+    pool->ent_words[ent] = 0 ;
+  }
+
+  ++pool->n_states ;
+
+  /* an entry without a slot yet, `pool_set` does the packing */
+  handle_t h = ((handle_t)pool->ent_gen[ent] << 32) | ent ;
+
+  pool->ent_words[ent] = 0xFF ;
+  pool->ent_slot[ent]  = (u32_t)RIGE_NPOS ;
+
+  if (RIGE_NPOS == pool_set(pool, h, owner, armies, cards)) {
+    pool_del(pool, h) ;
+
+    return (handle_t)RIGE_NPOS ;
+  }
+
+  return h ;
+}
+
+_RIGE_API usiz_t pool_get (const pool_t * pool, handle_t h, u8_t * owner, u32_t * armies, u64_t * cards)
+{
+  if (RIGE_NULL == pool || RIGE_NULL == owner || RIGE_NULL == armies)
+    return RIGE_NPOS ;
+
+  usiz_t ent = _pool_entry(pool, h) ;
+
+  if (RIGE_NPOS == ent)
+    return RIGE_NPOS ;
+
+  usiz_t words = pool->ent_words[ent] ;
+
+  /* unpack into the working board of the match being stepped */
+  _pool_decode(pool, pool->slab[words] + (usiz_t)pool->ent_slot[ent] * words, owner, armies, cards) ;
+
+  return pool->n_terr ;
+}
+
+_RIGE_API usiz_t pool_set (pool_t * pool, handle_t h, const u8_t * owner, const u32_t * armies, const u64_t * cards)
+{
+  if (RIGE_NULL == pool || RIGE_NULL == owner || RIGE_NULL == armies || (0 != pool->n_cards && RIGE_NULL == cards))
+    return RIGE_NPOS ;
+
+  usiz_t ent = _pool_entry(pool, h) ;
+
+  if (RIGE_NPOS == ent)
+    return RIGE_NPOS ;
+
+  for (usiz_t t = 0 ; t < pool->n_terr ; ++t) {
+    if ((1 << _POOL_OWNER_BITS) <= owner[t])
+      return RIGE_NPOS ;
+  }
+
+  usiz_t words = (_pool_bits(pool, armies) + 63) / 64 ;
+  usiz_t old = pool->ent_words[ent] ;
+
+  /* the state changed size, move it to the matching slab */
+  if (words != old) {
+    usiz_t nfree = pool->slab_nfree[words] ;
+    usiz_t slot = _pool_slot_new(pool, words) ;
+
+    if (RIGE_NPOS == slot)
+      return RIGE_NPOS ;
+
+    /* the old slot cannot be given back, undo taking the new one so the
+     * state stays where it was instead of leaking a slot
+     */
+    if (0xFF != old && 0 != _pool_slot_del(pool, old, pool->ent_slot[ent])) {
+      if (nfree != pool->slab_nfree[words]) {
+        ++pool->slab_nfree[words] ;
+      } else {
+        --pool->slab_used[words] ;
+      }
+
+      return RIGE_NPOS ;
+    }
+
+    pool->ent_slot[ent]  = slot ;
+    pool->ent_words[ent] = words ;
+  }
+
+  u64_t * state = pool->slab[words] + (usiz_t)pool->ent_slot[ent] * words ;
+
+  mem_set(state, 0, words * sizeof(u64_t)) ;
+  _pool_encode(pool, state, owner, armies, cards) ;
+
+  return words * sizeof(u64_t) ;
+}
+
+_RIGE_API void pool_del (pool_t * pool, handle_t h)
+{
+  if (RIGE_NULL == pool)
+    return ;
+
+  usiz_t ent = _pool_entry(pool, h) ;
+
+  if (RIGE_NPOS == ent)
+    return ;
+
+  /* like the entry below, a slot that cannot be listed as free stays
+   * unused until `pool_free`, the handle is invalidated either way
+   */
+  if (0xFF != pool->ent_words[ent]) {
+    _pool_slot_del(pool, pool->ent_words[ent], pool->ent_slot[ent]) ;
+  }
+
+  /* old handles to this entry are stale from now on */
+  ++pool->ent_gen[ent] ;
+  pool->ent_words[ent] = 0 ;
+  --pool->n_states ;
+
+  usiz_t n = pool->ent_nfree ;
+
+  if (0 == (n & (n - 1))) {
+    usiz_t cap = 0 == n ? 1 : 2 * n ;
+    u32_t * list = (u32_t *)mem_realloc(pool->ent_free, cap * sizeof(u32_t)) ;
+
+    /* the entry leaks, but the handle is still invalidated */
+    if (RIGE_NULL == list)
+      return ;
+
+    pool->ent_free = list ;
+  }
+
+  pool->ent_free[pool->ent_nfree++] = ent ;
+}
+
+_RIGE_API usiz_t pool_bytes (const pool_t * pool)
+{
+  if (RIGE_NULL == pool)
+    return RIGE_NPOS ;
+
+  /* everything the pool holds, slack of the growable arrays included */
+  usiz_t bytes = pool->ent_cap * (2 * sizeof(u32_t) + sizeof(u8_t)) ;
+
+  for (usiz_t w = 1 ; w <= pool->max_words ; ++w) {
+    bytes += pool->slab_cap[w] * w * sizeof(u64_t) ;
+    bytes += pool->slab_nfree[w] * sizeof(u32_t) ;
+  }
+
+  return bytes + pool->ent_nfree * sizeof(u32_t) ;
+}
+
+#undef _POOL_OWNER_BITS
+#undef _POOL_BUCKET_BITS
+
+/* ----------------------------------------------------------------
+ * board
+ */
+
+_RIGE_API usiz_t board_init (board_t * board, const map_t * map, usiz_t n_players)
+{
+  if (RIGE_NULL == board || RIGE_NULL == map || 0 == n_players || BOARD_NONE <= n_players)
+    return RIGE_NPOS ;
+
+  usiz_t n_cont = map->n_cont ;
+
+  board->map        = map ;
+  board->epoch      = map->epoch ;
+  board->n_players  = n_players ;
+  board->n_cont     = n_cont ;
+  board->owner      = (u8_t *)mem_alloc(map->n_terr) ;
+  board->armies     = (u32_t *)mem_calloc(map->n_terr, sizeof(u32_t)) ;
+  board->n_owned    = (u32_t *)mem_calloc(n_players, sizeof(u32_t)) ;
+  board->cont_owned = 0 == n_cont ? RIGE_NULL : (u32_t *)mem_calloc(n_players * n_cont, sizeof(u32_t)) ;
+  board->bonus      = (u32_t *)mem_calloc(n_players, sizeof(u32_t)) ;
+
+  if (
+    RIGE_NULL == board->owner || RIGE_NULL == board->armies || RIGE_NULL == board->n_owned ||
+    (0 != n_cont && RIGE_NULL == board->cont_owned) || RIGE_NULL == board->bonus
+  ) {
+    board_free(board) ;
+    return RIGE_NPOS ;
+  }
+
+  /* nobody owns anything yet, all the counters are zero */
+  mem_set(board->owner, BOARD_NONE, map->n_terr) ;
+
+  return map->n_terr ;
+}
+
+_RIGE_API void board_free (board_t * board)
+{
+  if (RIGE_NULL == board)
+    return ;
+
+  mem_dealloc(board->owner) ;
+  mem_dealloc(board->armies) ;
+  mem_dealloc(board->n_owned) ;
+  mem_dealloc(board->cont_owned) ;
+  mem_dealloc(board->bonus) ;
+
+  board->owner      = RIGE_NULL ;
+  board->armies     = RIGE_NULL ;
+  board->n_owned    = RIGE_NULL ;
+  board->cont_owned = RIGE_NULL ;
+  board->bonus      = RIGE_NULL ;
+}
+
+_RIGE_API i32_t board_set_owner (board_t * board, u32_t terr, u8_t player, u8_t * prev_owner)
+{
+  /* `BOARD_NONE` is a valid previous owner, so errors are reported apart */
+  if (RIGE_NULL == board || board->map->n_terr <= terr || (BOARD_NONE != player && board->n_players <= player))
+    return -1 ;
+
+  const map_t * map = board->map ;
+  usiz_t n_cont = board->n_cont ;
+
+  /* the counters are for the continents the board was made with */
+  if (board->epoch != map->epoch)
+    return -1 ;
+
+  u8_t prev = board->owner[terr] ;
+
+  if (RIGE_NULL != prev_owner) {
+    *prev_owner = prev ;
+  }
+
+  if (prev == player)
+    return 0 ;
+
+  board->owner[terr] = player ;
+
+  /* O(1) in the size of the map: only the two players and the continent
+   * of `terr` change
+   */
+  if (BOARD_NONE != prev) {
+    --board->n_owned[prev] ;
+
+    if (0 != n_cont) {
+      u32_t c = map->cont[terr] ;
+
+      if (map->cont_size[c] == board->cont_owned[prev * n_cont + c]--) {
+        board->bonus[prev] -= map->cont_bonus[c] ;
+      }
+    }
+  }
+
+  if (BOARD_NONE != player) {
+    ++board->n_owned[player] ;
+
+    if (0 != n_cont) {
+      u32_t c = map->cont[terr] ;
+
+      if (map->cont_size[c] == ++board->cont_owned[player * n_cont + c]) {
+        board->bonus[player] += map->cont_bonus[c] ;
+      }
+    }
+  }
+
+#ifdef _RIGE_HAS_BOARD_CHECK
+  if (0 != board_check(board)) {
+    fprintf(stderr, "board_set_owner: counters out of sync after territory %u\n", (unsigned)terr) ;
+    abort() ;
+  }
+#endif
+
+  /* undo is `board_set_owner(board, terr, prev, RIGE_NULL)` */
+  return 0 ;
+}
+
+_RIGE_API u32_t board_income (const board_t * board, u8_t player)
+{
+  if (RIGE_NULL == board || board->n_players <= player)
+    return 0 ;
+
+  u32_t n_owned = board->n_owned[player] ;
+
+  /* out of the game */
+  if (0 == n_owned)
+    return 0 ;
+
+  return (n_owned < 9 ? 3 : n_owned / 3) + board->bonus[player] ;
+}
+
+_RIGE_API u32_t board_income_scan (const board_t * board, u8_t player)
+{
+  if (RIGE_NULL == board || board->n_players <= player)
+    return 0 ;
+
+  /* the same as `board_income` from scratch, for checks and comparisons */
+  const map_t * map = board->map ;
+  u32_t n_owned = 0 ;
+
+  if (board->epoch != map->epoch)
+    return 0 ;
+
+  u32_t bonus = 0 ;
+
+  for (u32_t t = 0 ; t < map->n_terr ; ++t)
+    n_owned += player == board->owner[t] ;
+
+  if (0 == n_owned)
+    return 0 ;
+
+  for (u32_t c = 0 ; c < board->n_cont ; ++c) {
+    u32_t owned = 0 ;
+
+    for (u32_t t = 0 ; t < map->n_terr ; ++t)
+      owned += c == map->cont[t] && player == board->owner[t] ;
+
+    if (owned == map->cont_size[c]) {
+      bonus += map->cont_bonus[c] ;
+    }
+  }
+
+  return (n_owned < 9 ? 3 : n_owned / 3) + bonus ;
+}
+
+_RIGE_API i32_t board_features (const board_t * board, u8_t player, f32_t * feat)
+{
+  if (RIGE_NULL == board || RIGE_NULL == feat || board->n_players <= player)
+    return -1 ;
+
+  const map_t * map = board->map ;
+  usiz_t n_cont = board->n_cont ;
+
+  if (board->epoch != map->epoch)
+    return -1 ;
+
+  /* the generic version of `bset*_features`. the territories of `player`
+   * with an enemy neighbor are its border, the enemy ones with a
+   * neighbor of `player` the front, every one is counted once
+   */
+  u64_t own_armies = 0 ;
+  u64_t enemy_armies = 0 ;
+  f32_t continent = 0.0f ;
+
+  for (u32_t t = 0 ; t < map->n_terr ; ++t) {
+    i32_t mine = player == board->owner[t] ;
+
+    for (u32_t i = map->adj_off[t] ; i < map->adj_off[t + 1] ; ++i) {
+      if (mine != (player == board->owner[map->adj[i]])) {
+        if (mine) {
+          own_armies += board->armies[t] ;
+        } else {
+          enemy_armies += board->armies[t] ;
+        }
+
+        break ;
+      }
+    }
+  }
+
+  for (u32_t c = 0 ; c < n_cont ; ++c)
+    continent += (f32_t)board->cont_owned[player * n_cont + c] / (f32_t)map->cont_size[c] ;
+
+  u64_t enemy = 0 == enemy_armies ? 1 : enemy_armies ;
+
+  feat[EVAL_BORDER_RATIO] = (f32_t)own_armies / (f32_t)enemy ;
+  feat[EVAL_CONTINENT]    = continent ;
+  feat[EVAL_INCOME]       = (f32_t)board_income(board, player) ;
+
+  return 0 ;
+}
+
+_RIGE_API i32_t board_check (const board_t * board)
+{
+  if (RIGE_NULL == board)
+    return -1 ;
+
+  const map_t * map = board->map ;
+  usiz_t n_cont = board->n_cont ;
+
+  if (board->epoch != map->epoch)
+    return -1 ;
+
+  for (u8_t p = 0 ; p < board->n_players ; ++p) {
+    u32_t n_owned = 0 ;
+    u32_t bonus = 0 ;
+
+    for (u32_t t = 0 ; t < map->n_terr ; ++t)
+      n_owned += p == board->owner[t] ;
+
+    if (n_owned != board->n_owned[p])
+      return -1 ;
+
+    for (u32_t c = 0 ; c < n_cont ; ++c) {
+      u32_t owned = 0 ;
+
+      for (u32_t t = 0 ; t < map->n_terr ; ++t)
+        owned += c == map->cont[t] && p == board->owner[t] ;
+
+      if (owned != board->cont_owned[p * n_cont + c])
+        return -1 ;
+
+      if (owned == map->cont_size[c]) {
+        bonus += map->cont_bonus[c] ;
+      }
+    }
+
+    if (bonus != board->bonus[p])
+      return -1 ;
+  }
+
+  return 0 ;
+}
+
+/* ----------------------------------------------------------------
+ * mapgen
+ */
+
+typedef struct _mapgen_s _mapgen_t ;
+
+struct _mapgen_s {
+  i32v_t         size    ;
+  u32_t *        cells   ;
+  i32v_t *       seeds   ;
+  i32v_t         buckets ;
+  u32_t *        first   ;
+  _Atomic usiz_t next    ;
+} ;
+
+/* splitmix64, small and good enough for maps */
+static u64_t _mapgen_rand (u64_t * state)
+{
+  u64_t z = (*state += 0x9E3779B97F4A7C15ULL) ;
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL ;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL ;
+
+  return z ^ (z >> 31) ;
+}
+
+/* terminal cells are about twice as tall as wide */
+#define _mapgen_dist(a, b) \
+  (((i64_t)(a).x - (b).x) * ((i64_t)(a).x - (b).x) + 4 * ((i64_t)(a).y - (b).y) * ((i64_t)(a).y - (b).y))
+
+/* the bucket of coordinate `x` along an axis of `size` cells split in
+ * `n` buckets, the seeds are placed with the inverse below so both agree
+ */
+static i32_t _mapgen_bucket (i64_t x, i64_t size, i64_t n)
+{
+  return (i32_t)(x * n / size) ;
+}
+
+/* the first coordinate `_mapgen_bucket` puts in bucket `b` */
+static i64_t _mapgen_bucket_start (i64_t b, i64_t size, i64_t n)
+{
+  return (b * size + n - 1) / n ;
+}
+
+static u32_t _mapgen_nearest (const _mapgen_t * gen, i32v_t cell)
+{
+  i32v_t bucket = vec_set(
+    _mapgen_bucket(cell.x, gen->size.x, gen->buckets.x),
+    _mapgen_bucket(cell.y, gen->size.y, gen->buckets.y)
+  ) ;
+
+  /* every seed in ring `r` of buckets is at least `r - 1` buckets away */
+  i64_t step = gen->size.x / gen->buckets.x ;
+  i64_t step_y = 2 * (gen->size.y / gen->buckets.y) ;
+
+  if (step_y < step) {
+    step = step_y ;
+  }
+
+  u32_t best = (u32_t)RIGE_NPOS ;
+  i64_t best_dist = INT64_MAX ;
+
+  for (i32_t r = 0 ; ; ++r) {
+    for (i32_t by = bucket.y - r ; by <= bucket.y + r ; ++by) {
+      if (by < 0 || gen->buckets.y <= by)
+        continue ;
+
+      for (i32_t bx = bucket.x - r ; bx <= bucket.x + r ; ++bx) {
+        /* only the border of the ring, the inside was done already */
+        if (bx < 0 || gen->buckets.x <= bx || (bx != bucket.x - r && bx != bucket.x + r && by != bucket.y - r && by != bucket.y + r))
+          continue ;
+
+        usiz_t b = (usiz_t)by * gen->buckets.x + bx ;
+
+        for (u32_t t = gen->first[b] ; t < gen->first[b + 1] ; ++t) {
+          i64_t dist = _mapgen_dist(cell, gen->seeds[t]) ;
+
+          if (dist < best_dist) {
+            best = t ;
+            best_dist = dist ;
+          }
+        }
+      }
+    }
+
+    if ((u32_t)RIGE_NPOS != best && best_dist <= (r * step) * (r * step))
+      break ;
+
+    if (gen->buckets.x < r && gen->buckets.y < r)
+      break ;
+  }
+
+  return best ;
+}
+
+static void * _mapgen_worker (void * arg)
+{
+  _mapgen_t * gen = (_mapgen_t *)arg ;
+
+  /* rasterize whole rows, handed out one at a time */
+  for (;;) {
+    usiz_t y = atomic_fetch_add(&gen->next, 1) ;
+
+    if ((usiz_t)gen->size.y <= y)
+      break ;
+
+    for (i32_t x = 0 ; x < gen->size.x ; ++x) {
+      i32v_t cell = vec_set(x, (i32_t)y) ;
+
+      gen->cells[y * gen->size.x + x] = _mapgen_nearest(gen, cell) ;
+    }
+  }
+
+  return RIGE_NULL ;
+}
+
+/* with the stretched metric on a grid of cells a territory can come out
+ * in pieces. the piece holding its seed stays, every other piece joins a
+ * territory it touches, so that every territory is connected and the
+ * borders form a planar graph. `mark` is 1 for the kept cells
+ */
+static usiz_t _mapgen_merge (const _mapgen_t * gen, usiz_t n_terr)
+{
+  i32v_t size = gen->size ;
+  u32_t * cells = gen->cells ;
+  usiz_t n_cells = (usiz_t)size.x * size.y ;
+
+  u8_t * mark = (u8_t *)mem_calloc(n_cells, sizeof(u8_t)) ;
+  usiz_t * queue = (usiz_t *)mem_alloc(n_cells * sizeof(usiz_t)) ;
+
+  if (RIGE_NULL == mark || RIGE_NULL == queue) {
+    mem_dealloc(mark) ;
+    mem_dealloc(queue) ;
+
+    return RIGE_NPOS ;
+  }
+
+  static const i32_t dx [4] = { 1 , -1 , 0 ,  0 } ;
+  static const i32_t dy [4] = { 0 ,  0 , 1 , -1 } ;
+  usiz_t n_merged = 0 ;
+
+  for (usiz_t t = 0 ; t < n_terr ; ++t) {
+    usiz_t c = (usiz_t)gen->seeds[t].y * size.x + gen->seeds[t].x ;
+    usiz_t head = 0 ;
+    usiz_t tail = 0 ;
+
+    mark[c] = 1 ;
+    queue[tail++] = c ;
+
+    while (head < tail) {
+      c = queue[head++] ;
+
+      for (i32_t d = 0 ; d < 4 ; ++d) {
+        i32_t x = (i32_t)(c % size.x) + dx[d] ;
+        i32_t y = (i32_t)(c / size.x) + dy[d] ;
+        usiz_t n = (usiz_t)y * size.x + x ;
+
+        if (x < 0 || size.x <= x || y < 0 || size.y <= y || 0 != mark[n] || t != cells[n])
+          continue ;
+
+        mark[n] = 1 ;
+        queue[tail++] = n ;
+      }
+    }
+  }
+
+  /* a piece may only touch other pieces, it joins in a later pass once a
+   * neighbor was merged. the layout is connected so every pass merges some
+   */
+  for (usiz_t left = 1 ; 0 != left ; ) {
+    left = 0 ;
+
+    for (usiz_t first = 0 ; first < n_cells ; ++first) {
+      if (0 != mark[first])
+        continue ;
+
+      u32_t t = cells[first] ;
+      u32_t into = (u32_t)RIGE_NPOS ;
+      usiz_t head = 0 ;
+      usiz_t tail = 0 ;
+
+      /* 2 marks the cells of the piece while it is collected */
+      mark[first] = 2 ;
+      queue[tail++] = first ;
+
+      while (head < tail) {
+        usiz_t c = queue[head++] ;
+
+        for (i32_t d = 0 ; d < 4 ; ++d) {
+          i32_t x = (i32_t)(c % size.x) + dx[d] ;
+          i32_t y = (i32_t)(c / size.x) + dy[d] ;
+          usiz_t n = (usiz_t)y * size.x + x ;
+
+          if (x < 0 || size.x <= x || y < 0 || size.y <= y)
+            continue ;
+
+          if (1 == mark[n] && (u32_t)RIGE_NPOS == into) {
+            into = cells[n] ;
+          }
+
+          if (0 == mark[n] && t == cells[n]) {
+            mark[n] = 2 ;
+            queue[tail++] = n ;
+          }
+        }
+      }
+
+      for (usiz_t i = 0 ; i < tail ; ++i) {
+        if ((u32_t)RIGE_NPOS == into) {
+          mark[queue[i]] = 3 ;
+        } else {
+          cells[queue[i]] = into ;
+          mark[queue[i]]  = 1 ;
+        }
+      }
+
+      if ((u32_t)RIGE_NPOS == into) {
+        left += tail ;
+      } else {
+        n_merged += tail ;
+      }
+    }
+
+    /* pieces left alone are looked at again in the next pass */
+    for (usiz_t c = 0 ; 0 != left && c < n_cells ; ++c) {
+      if (3 == mark[c]) {
+        mark[c] = 0 ;
+      }
+    }
+  }
+
+  mem_dealloc(mark) ;
+  mem_dealloc(queue) ;
+
+  return n_merged ;
+}
+
+static int _mapgen_comp_edge (const void * lhs, const void * rhs)
+{
+  u64_t a = *(const u64_t *)lhs ;
+  u64_t b = *(const u64_t *)rhs ;
+
+  return (a > b) - (a < b) ;
+}
+
+_RIGE_API usiz_t map_generate (map_t * map, usiz_t n_terr, usiz_t n_cont, i32v_t size, u64_t seed, usiz_t n_threads)
+{
+  if (RIGE_NULL == map || 0 == n_terr || 0 == n_cont || n_terr < n_cont || size.x <= 0 || size.y <= 0)
+    return RIGE_NPOS ;
+
+  /* seeds on a jittered grid of buckets with about the same aspect as
+   * the layout, so the buckets come out roughly square on screen
+   */
+  _mapgen_t gen ;
+  usiz_t n_cells = (usiz_t)size.x * size.y ;
+
+  gen.buckets.x = (i32_t)ceil(sqrt((f64_t)n_terr * size.x / (2.0 * size.y))) ;
+
+  if (gen.buckets.x < 1) {
+    gen.buckets.x = 1 ;
+  }
+
+  gen.buckets.y = (i32_t)((n_terr + gen.buckets.x - 1) / gen.buckets.x) ;
+
+  /* at least a cell per bucket */
+  if (size.x < gen.buckets.x || size.y < gen.buckets.y)
+    return RIGE_NPOS ;
+
+  usiz_t n_buckets = (usiz_t)gen.buckets.x * gen.buckets.y ;
+
+  /* `*map` is output only, like for `map_init` and `map_load` */
+  u32_t * cells = (u32_t *)mem_alloc(n_cells * sizeof(u32_t)) ;
+
+  gen.size  = size ;
+  gen.cells = cells ;
+  gen.seeds = (i32v_t *)mem_alloc(n_terr * sizeof(i32v_t)) ;
+  gen.first = (u32_t *)mem_alloc((n_buckets + 1) * sizeof(u32_t)) ;
+  atomic_init(&gen.next, 0) ;
+
+  if (RIGE_NULL == gen.seeds || RIGE_NULL == gen.first || RIGE_NULL == cells) {
+    mem_dealloc(gen.seeds) ;
+    mem_dealloc(gen.first) ;
+    mem_dealloc(cells) ;
+
+    return RIGE_NPOS ;
+  }
+
+  /* territory `t` lives in bucket `t`, the last buckets stay empty */
+  for (usiz_t b = 0 ; b <= n_buckets ; ++b)
+    gen.first[b] = b < n_terr ? b : n_terr ;
+
+  for (usiz_t t = 0 ; t < n_terr ; ++t) {
+    i64_t bx = t % gen.buckets.x ;
+    i64_t by = t / gen.buckets.x ;
+    i64_t x0 = _mapgen_bucket_start(bx, size.x, gen.buckets.x) ;
+    i64_t x1 = _mapgen_bucket_start(bx + 1, size.x, gen.buckets.x) ;
+    i64_t y0 = _mapgen_bucket_start(by, size.y, gen.buckets.y) ;
+    i64_t y1 = _mapgen_bucket_start(by + 1, size.y, gen.buckets.y) ;
+
+    gen.seeds[t].x = (i32_t)(x0 + _mapgen_rand(&seed) % (x1 - x0)) ;
+    gen.seeds[t].y = (i32_t)(y0 + _mapgen_rand(&seed) % (y1 - y0)) ;
+  }
+
+  /* fill the layout from all the cores, like `dist_build` */
+  if (0 == n_threads) {
+    long n_cpus = sysconf(_SC_NPROCESSORS_ONLN) ;
+
+    n_threads = n_cpus < 1 ? 1 : (usiz_t)n_cpus ;
+  }
+
+  if (64 < n_threads) {
+    n_threads = 64 ;
+  }
+
+  pthread_t threads [64] ;
+  usiz_t n_started ;
+
+  for (n_started = 0 ; n_started + 1 < n_threads ; ++n_started) {
+    if (0 != pthread_create(&threads[n_started], RIGE_NULL, _mapgen_worker, &gen))
+      break ;
+  }
+
+  _mapgen_worker(&gen) ;
+
+  for (usiz_t i = 0 ; i < n_started ; ++i)
+    pthread_join(threads[i], RIGE_NULL) ;
+
+  usiz_t n_merged = _mapgen_merge(&gen, n_terr) ;
+
+  mem_dealloc(gen.seeds) ;
+  mem_dealloc(gen.first) ;
+
+  /* two territories border when two of their cells touch */
+  u64_t * keys = RIGE_NPOS == n_merged ? RIGE_NULL : (u64_t *)mem_alloc(2 * n_cells * sizeof(u64_t)) ;
+
+  if (RIGE_NULL == keys) {
+    mem_dealloc(cells) ;
+    return RIGE_NPOS ;
+  }
+
+  usiz_t n_keys = 0 ;
+
+  for (i32_t y = 0 ; y < size.y ; ++y) {
+    for (i32_t x = 0 ; x < size.x ; ++x) {
+      u32_t a = cells[(usiz_t)y * size.x + x] ;
+
+      if (x + 1 < size.x && a != cells[(usiz_t)y * size.x + x + 1]) {
+        u32_t b = cells[(usiz_t)y * size.x + x + 1] ;
+
+        keys[n_keys++] = a < b ? ((u64_t)a << 32) | b : ((u64_t)b << 32) | a ;
+      }
+
+      if (y + 1 < size.y && a != cells[(usiz_t)(y + 1) * size.x + x]) {
+        u32_t b = cells[(usiz_t)(y + 1) * size.x + x] ;
+
+        keys[n_keys++] = a < b ? ((u64_t)a << 32) | b : ((u64_t)b << 32) | a ;
+      }
+    }
+  }
+
+  qsort(keys, n_keys, sizeof(u64_t), _mapgen_comp_edge) ;
+
+  /* unique pairs, unpacked in place as `map_init` edges */
+  u32_t * edges = (u32_t *)keys ;
+  usiz_t n_edges = 0 ;
+  u64_t prev = 0 ;
+
+  for (usiz_t i = 0 ; i < n_keys ; ++i) {
+    u64_t key = keys[i] ;
+
+    /* the pairs overwrite the keys behind, compare against a copy */
+    if (0 != i && key == prev)
+      continue ;
+
+    prev = key ;
+
+    edges[2 * n_edges + 0] = (u32_t)(key >> 32) ;
+    edges[2 * n_edges + 1] = (u32_t)key ;
+    ++n_edges ;
+  }
+
+  usiz_t retval = map_init(map, n_terr, edges, n_edges) ;
+
+  mem_dealloc(keys) ;
+
+  map->size  = size ;
+  map->cells = cells ;
+
+  if (RIGE_NPOS == retval) {
+    map_free(map) ;
+    return RIGE_NPOS ;
+  }
+
+  /* continents grow together from `n_cont` random territories, a
+   * breadth-first search over the borders with every root at once
+   */
+  u32_t * cont  = (u32_t *)mem_alloc(n_terr * sizeof(u32_t)) ;
+  u32_t * bonus = (u32_t *)mem_calloc(n_cont, sizeof(u32_t)) ;
+  u32_t * queue = (u32_t *)mem_alloc(n_terr * sizeof(u32_t)) ;
+
+  if (RIGE_NULL == cont || RIGE_NULL == bonus || RIGE_NULL == queue) {
+    mem_dealloc(cont) ;
+    mem_dealloc(bonus) ;
+    mem_dealloc(queue) ;
+    map_free(map) ;
+
+    return RIGE_NPOS ;
+  }
+
+  mem_set(cont, 0xFF, n_terr * sizeof(u32_t)) ;
+
+  usiz_t head = 0 ;
+  usiz_t tail = 0 ;
+
+  for (u32_t c = 0 ; c < n_cont ; ++c) {
+    u32_t t = _mapgen_rand(&seed) % n_terr ;
+
+    /* skip the territories already taken */
+    while ((u32_t)RIGE_NPOS != cont[t])
+      t = (t + 1) % n_terr ;
+
+    cont[t] = c ;
+    queue[tail++] = t ;
+  }
+
+  while (head < tail) {
+    u32_t t = queue[head++] ;
+
+    for (u32_t i = map->adj_off[t] ; i < map->adj_off[t + 1] ; ++i) {
+      u32_t n = map->adj[i] ;
+
+      if ((u32_t)RIGE_NPOS == cont[n]) {
+        cont[n] = cont[t] ;
+        queue[tail++] = n ;
+      }
+    }
+  }
+
+  /* a territory with no neighbors, a continent on its own is too much */
+  for (u32_t t = 0 ; t < n_terr ; ++t) {
+    if ((u32_t)RIGE_NPOS == cont[t]) {
+      cont[t] = 0 ;
+    }
+  }
+
+  /* as on the classic map, a continent is worth about as much as the
+   * number of its territories that must be defended
+   */
+  for (u32_t t = 0 ; t < n_terr ; ++t) {
+    for (u32_t i = map->adj_off[t] ; i < map->adj_off[t + 1] ; ++i) {
+      if (cont[t] != cont[map->adj[i]]) {
+        ++bonus[cont[t]] ;
+        break ;
+      }
+    }
+  }
+
+  for (u32_t c = 0 ; c < n_cont ; ++c) {
+    if (0 == bonus[c]) {
+      bonus[c] = 1 ;
+    }
+  }
+
+  retval = map_set_continents(map, n_cont, cont, bonus) ;
+
+  mem_dealloc(cont) ;
+  mem_dealloc(bonus) ;
+  mem_dealloc(queue) ;
+
+  if (RIGE_NPOS == retval) {
+    map_free(map) ;
+    return RIGE_NPOS ;
+  }
+
+  return n_terr ;
+}
+
+#undef _mapgen_dist
+
+/* ----------------------------------------------------------------
+ * map files
+ */
+
+/* plain text, one record per line:
+ *
+ *   risk-map 1
+ *   size <width> <height>          (only with a layout)
+ *   territories <n>
+ *   continents <n>
+ *   bonus <continent> <armies>
+ *   territory <territory> <continent>
+ *   border <territory> <territory>
+ *   row <y> <territory> <cells> <territory> <cells> ...
+ *
+ * ids are the ones of the file, a reordered map is saved in its original
+ * order
+ */
+static usiz_t _map_save (const map_t * map, const cstr_t path)
+{
+  if (RIGE_NULL == map || RIGE_NULL == map->adj_off || RIGE_NULL == path)
+    return RIGE_NPOS ;
+
+  strbuf_t sb ;
+  usiz_t ok = 1 ;
+
+  strbuf_init(&sb) ;
+
+  ok = ok && RIGE_NPOS != strbuf_append(&sb, "risk-map 1\n") ;
+
+  /* a map from `map_init` has no layout, no `size` and no `row` records */
+  if (RIGE_NULL != map->cells) {
+    ok = ok && RIGE_NPOS != strbuf_append(&sb, "size ") ;
+    ok = ok && RIGE_NPOS != strbuf_append_i64(&sb, map->size.x, 10) ;
+    ok = ok && RIGE_NPOS != strbuf_append_chr(&sb, ' ') ;
+    ok = ok && RIGE_NPOS != strbuf_append_i64(&sb, map->size.y, 10) ;
+    ok = ok && RIGE_NPOS != strbuf_append_chr(&sb, '\n') ;
+  }
+
+  ok = ok && RIGE_NPOS != strbuf_append(&sb, "territories ") ;
+  ok = ok && RIGE_NPOS != strbuf_append_u64(&sb, map->n_terr, 10) ;
+  ok = ok && RIGE_NPOS != strbuf_append(&sb, "\ncontinents ") ;
+  ok = ok && RIGE_NPOS != strbuf_append_u64(&sb, map->n_cont, 10) ;
+  ok = ok && RIGE_NPOS != strbuf_append_chr(&sb, '\n') ;
+
+  for (u32_t c = 0 ; ok && c < map->n_cont ; ++c) {
+    ok = ok && RIGE_NPOS != strbuf_append(&sb, "bonus ") ;
+    ok = ok && RIGE_NPOS != strbuf_append_u64(&sb, c, 10) ;
+    ok = ok && RIGE_NPOS != strbuf_append_chr(&sb, ' ') ;
+    ok = ok && RIGE_NPOS != strbuf_append_u64(&sb, map->cont_bonus[c], 10) ;
+    ok = ok && RIGE_NPOS != strbuf_append_chr(&sb, '\n') ;
+  }
+
+  for (u32_t t = 0 ; ok && t < map->n_terr && 0 != map->n_cont ; ++t) {
+    ok = ok && RIGE_NPOS != strbuf_append(&sb, "territory ") ;
+    ok = ok && RIGE_NPOS != strbuf_append_u64(&sb, map_to_old(map, t), 10) ;
+    ok = ok && RIGE_NPOS != strbuf_append_chr(&sb, ' ') ;
+    ok = ok && RIGE_NPOS != strbuf_append_u64(&sb, map->cont[t], 10) ;
+    ok = ok && RIGE_NPOS != strbuf_append_chr(&sb, '\n') ;
+  }
+
+  for (u32_t t = 0 ; ok && t < map->n_terr ; ++t) {
+    for (u32_t i = map->adj_off[t] ; ok && i < map->adj_off[t + 1] ; ++i) {
+      /* every border once */
+      if (map->adj[i] < t)
+        continue ;
+
+      ok = ok && RIGE_NPOS != strbuf_append(&sb, "border ") ;
+      ok = ok && RIGE_NPOS != strbuf_append_u64(&sb, map_to_old(map, t), 10) ;
+      ok = ok && RIGE_NPOS != strbuf_append_chr(&sb, ' ') ;
+      ok = ok && RIGE_NPOS != strbuf_append_u64(&sb, map_to_old(map, map->adj[i]), 10) ;
+      ok = ok && RIGE_NPOS != strbuf_append_chr(&sb, '\n') ;
+    }
+  }
+
+  /* the layout is run-length encoded, territories span many cells */
+  for (i32_t y = 0 ; ok && RIGE_NULL != map->cells && y < map->size.y ; ++y) {
+    const u32_t * row = map->cells + (usiz_t)y * map->size.x ;
+
+    ok = ok && RIGE_NPOS != strbuf_append(&sb, "row ") ;
+    ok = ok && RIGE_NPOS != strbuf_append_i64(&sb, y, 10) ;
+
+    for (i32_t x = 0 ; ok && x < map->size.x ; ) {
+      i32_t run = 1 ;
+
+      while (x + run < map->size.x && row[x + run] == row[x])
+        ++run ;
+
+      ok = ok && RIGE_NPOS != strbuf_append_chr(&sb, ' ') ;
+      ok = ok && RIGE_NPOS != strbuf_append_u64(&sb, map_to_old(map, row[x]), 10) ;
+      ok = ok && RIGE_NPOS != strbuf_append_chr(&sb, ' ') ;
+      ok = ok && RIGE_NPOS != strbuf_append_i64(&sb, run, 10) ;
+
+      x += run ;
+    }
+
+    ok = ok && RIGE_NPOS != strbuf_append_chr(&sb, '\n') ;
+  }
+
+  FILE * file = 0 == ok ? RIGE_NULL : fopen(path, "w") ;
+
+  if (RIGE_NULL != file) {
+    ok = sb.size == fwrite(sb.data, 1, sb.size, file) ;
+    ok = 0 == fclose(file) && ok ;
+  } else {
+    ok = 0 ;
+  }
+
+  usiz_t size = sb.size ;
+
+  strbuf_free(&sb) ;
+
+  if (0 == ok)
+    return RIGE_NPOS ;
+
+  return size ;
+}
+
+_RIGE_API usiz_t map_save (const map_t * map, const cstr_t path)
+{
+  RIGE_PROF_BEGIN(PROF_IO) ;
+
+  usiz_t retval = _map_save(map, path) ;
+
+  RIGE_PROF_END(PROF_IO) ;
+
+  return retval ;
+}
+
+/* the next number on the line, `RIGE_NPOS` if there is none */
+static usiz_t _map_next (chr_t ** ptr, chr_t * end, u64_t * val)
+{
+  while (*ptr < end && chr_is_space_hor(**ptr))
+    ++*ptr ;
+
+  usiz_t size = num_parse_u64(*ptr, end - *ptr, 10, val) ;
+
+  if (RIGE_NPOS == size)
+    return RIGE_NPOS ;
+
+  *ptr += size ;
+
+  return size ;
+}
+
+static usiz_t _map_load (map_t * map, const cstr_t path)
+{
+  if (RIGE_NULL == map || RIGE_NULL == path)
+    return RIGE_NPOS ;
+
+  FILE * file = fopen(path, "rb") ;
+
+  if (RIGE_NULL == file)
+    return RIGE_NPOS ;
+
+  fseek(file, 0, SEEK_END) ;
+
+  long file_size = ftell(file) ;
+
+  fseek(file, 0, SEEK_SET) ;
+
+  chr_t * text = file_size < 0 ? RIGE_NULL : (chr_t *)mem_alloc(file_size + 1) ;
+
+  if (RIGE_NULL == text || (usiz_t)file_size != fread(text, 1, file_size, file)) {
+    mem_dealloc(text) ;
+    fclose(file) ;
+
+    return RIGE_NPOS ;
+  }
+
+  fclose(file) ;
+  text[file_size] = 0 ;
+
+  u64_t n_terr = 0 ;
+  u64_t n_cont = 0 ;
+  i32v_t size = vec_set(0, 0) ;
+  u32_t * cont   = RIGE_NULL ;
+  u32_t * bonus  = RIGE_NULL ;
+  u32_t * edges  = RIGE_NULL ;
+  u32_t * cells  = RIGE_NULL ;
+  usiz_t n_edges = 0 ;
+  usiz_t cap     = 0 ;
+  usiz_t ok      = 11 <= file_size && 0 == cstr_n_comp(text, "risk-map 1\n", 11) ;
+
+  chr_t * line = text ;
+  chr_t * text_end = text + file_size ;
+
+  while (ok && line < text_end) {
+    usiz_t line_size = cstr_n_chr(line, '\n', text_end - line) ;
+    chr_t * end = RIGE_NPOS == line_size ? text_end : line + line_size ;
+    usiz_t word = cstr_n_for_each(line, end - line, chr_is_alpha) ;
+    chr_t * ptr = line + word ;
+    u64_t a , b ;
+
+    line = end + 1 ;
+
+    if (5 == word && 0 == cstr_n_comp(ptr - word, "bonus", word)) {
+      ok = RIGE_NULL != bonus && RIGE_NPOS != _map_next(&ptr, end, &a) && RIGE_NPOS != _map_next(&ptr, end, &b) && a < n_cont ;
+
+      if (ok) {
+        bonus[a] = b ;
+      }
+    } else if (9 == word && 0 == cstr_n_comp(ptr - word, "territory", word)) {
+      ok = RIGE_NULL != cont && RIGE_NPOS != _map_next(&ptr, end, &a) && RIGE_NPOS != _map_next(&ptr, end, &b) && a < n_terr && b < n_cont ;
+
+      if (ok) {
+        cont[a] = b ;
+      }
+    } else if (6 == word && 0 == cstr_n_comp(ptr - word, "border", word)) {
+      ok = RIGE_NPOS != _map_next(&ptr, end, &a) && RIGE_NPOS != _map_next(&ptr, end, &b) && a < n_terr && b < n_terr ;
+
+      if (ok && n_edges == cap) {
+        cap = 0 == cap ? 64 : 2 * cap ;
+
+        u32_t * grown = (u32_t *)mem_realloc(edges, 2 * cap * sizeof(u32_t)) ;
+
+        ok = RIGE_NULL != grown ;
+
+        if (ok) {
+          edges = grown ;
+        }
+      }
+
+      if (ok) {
+        edges[2 * n_edges + 0] = a ;
+        edges[2 * n_edges + 1] = b ;
+        ++n_edges ;
+      }
+    } else if (3 == word && 0 == cstr_n_comp(ptr - word, "row", word)) {
+      ok = RIGE_NULL != cells && RIGE_NPOS != _map_next(&ptr, end, &a) && a < (u64_t)size.y ;
+
+      u32_t * row = ok ? cells + a * size.x : RIGE_NULL ;
+      u64_t x = 0 ;
+
+      while (ok && RIGE_NPOS != _map_next(&ptr, end, &a)) {
+        ok = RIGE_NPOS != _map_next(&ptr, end, &b) && a < n_terr && x + b <= (u64_t)size.x ;
+
+        for (u64_t i = 0 ; ok && i < b ; ++i)
+          row[x++] = a ;
+      }
+    } else if (4 == word && 0 == cstr_n_comp(ptr - word, "size", word)) {
+      ok = RIGE_NULL == cells && RIGE_NPOS != _map_next(&ptr, end, &a) && RIGE_NPOS != _map_next(&ptr, end, &b) ;
+      ok = ok && 0 < a && a <= INT32_MAX && 0 < b && b <= INT32_MAX ;
+
+      if (ok) {
+        size.x = (i32_t)a ;
+        size.y = (i32_t)b ;
+        cells  = (u32_t *)mem_calloc(a * b, sizeof(u32_t)) ;
+        ok     = RIGE_NULL != cells ;
+      }
+    } else if (11 == word && 0 == cstr_n_comp(ptr - word, "territories", word)) {
+      ok = 0 == n_terr && RIGE_NPOS != _map_next(&ptr, end, &n_terr) && 0 < n_terr && n_terr < (u32_t)RIGE_NPOS ;
+
+      if (ok) {
+        cont = (u32_t *)mem_calloc(n_terr, sizeof(u32_t)) ;
+        ok   = RIGE_NULL != cont ;
+      }
+    } else if (10 == word && 0 == cstr_n_comp(ptr - word, "continents", word)) {
+      ok = 0 == n_cont && RIGE_NPOS != _map_next(&ptr, end, &n_cont) && n_cont < (u32_t)RIGE_NPOS ;
+
+      if (ok && 0 != n_cont) {
+        bonus = (u32_t *)mem_calloc(n_cont, sizeof(u32_t)) ;
+        ok    = RIGE_NULL != bonus ;
+      }
+    }
+
+    /* unknown records are skipped, newer files stay readable */
+  }
+
+  ok = ok && 0 != n_terr ;
+  ok = ok && RIGE_NPOS != map_init(map, n_terr, edges, n_edges) ;
+
+  if (ok && 0 != n_cont && RIGE_NPOS == map_set_continents(map, n_cont, cont, bonus)) {
+    map_free(map) ;
+    ok = 0 ;
+  }
+
+  if (ok) {
+    map->size  = size ;
+    map->cells = cells ;
+    cells      = RIGE_NULL ;
+  }
+
+  mem_dealloc(text) ;
+  mem_dealloc(cont) ;
+  mem_dealloc(bonus) ;
+  mem_dealloc(edges) ;
+  mem_dealloc(cells) ;
+
+  if (0 == ok)
+    return RIGE_NPOS ;
+
+  return n_terr ;
+}
+
+_RIGE_API usiz_t map_load (map_t * map, const cstr_t path)
+{
+  RIGE_PROF_BEGIN(PROF_IO) ;
+
+  usiz_t retval = _map_load(map, path) ;
+
+  RIGE_PROF_END(PROF_IO) ;
+
+  return retval ;
 }
\ No newline at end of file
@@ -7,6 +7,8 @@
 # include <stdarg.h>
 # include <stdio.h>
 # include <math.h>
+# include <stdatomic.h>
+# include <pthread.h>
 
 # define RIGE_VERSION_MAJOR 0
 # define RIGE_VERSION_MINOR 0
@@ -29,6 +31,8 @@ typedef int8_t    i8_t   ;
 typedef int16_t   i16_t  ;
 typedef int32_t   i32_t  ;
 typedef int64_t   i64_t  ;
+typedef float     f32_t  ;
+typedef double    f64_t  ;
 typedef uintptr_t uptr_t ;
 typedef intptr_t  iptr_t ;
 typedef uptr_t    usiz_t ;
@@ -37,6 +41,40 @@ typedef iptr_t    isiz_t ;
 # define RIGE_NULL ((ptr_t)0)
 # define RIGE_NPOS ((usiz_t)-1)
 
+/* profiling probes, enabled by defining `_RIGE_HAS_PROF`. when it is not
+ * defined every `RIGE_PROF_*` macro compiles to nothing. `PROF_MOVEGEN`
+ * times `map_attacks`, `PROF_IO` the map, dist and eval files.
+ * `PROF_BATTLE` and `PROF_RENDER` are for the game, RiGE has neither
+ */
+
+enum {
+  PROF_MEM_ALLOC   ,
+  PROF_MEM_REALLOC ,
+  PROF_MEM_DEALLOC ,
+  PROF_MOVEGEN     ,
+  PROF_BATTLE      ,
+  PROF_RENDER      ,
+  PROF_IO          ,
+  PROF_COUNT
+} ;
+
+# ifdef _RIGE_HAS_PROF
+_RIGE_API u64_t prof_now (void) ;
+_RIGE_API void prof_count (i32_t id, u64_t bytes) ;
+_RIGE_API void prof_time (i32_t id, u64_t start, u64_t stop) ;
+_RIGE_API void prof_dump (FILE * file) ;
+_RIGE_API void prof_dump_trace (FILE * file) ;
+_RIGE_API void prof_at_exit (const char * trace_path) ;
+
+#  define RIGE_PROF_COUNT(_id, _bytes) prof_count((_id), (_bytes))
+#  define RIGE_PROF_BEGIN(_id)         u64_t _prof_start_ ## _id = prof_now()
+#  define RIGE_PROF_END(_id)           prof_time((_id), _prof_start_ ## _id, prof_now())
+# else
+#  define RIGE_PROF_COUNT(_id, _bytes) ((void)0)
+#  define RIGE_PROF_BEGIN(_id)         ((void)0)
+#  define RIGE_PROF_END(_id)           ((void)0)
+# endif
+
 _RIGE_API ptr_t mem_alloc (usiz_t size) ;
 _RIGE_API ptr_t mem_calloc (usiz_t n, usiz_t size) ;
 _RIGE_API ptr_t mem_realloc (ptr_t ptr, usiz_t size) ;
@@ -46,6 +84,7 @@ _RIGE_API usiz_t mem_move (ptr_t dst, const ptr_t src, usiz_t n) ;
 _RIGE_API usiz_t mem_set (ptr_t ptr, i32_t chr, usiz_t n) ;
 _RIGE_API i32_t mem_comp (const ptr_t lhs, const ptr_t rhs, usiz_t n) ;
 _RIGE_API usiz_t mem_for_each (const ptr_t ptr, usiz_t n, i32_t (* pred) (i32_t)) ;
+_RIGE_API u32_t mem_hash_djb2 (const ptr_t ptr, usiz_t n) ;
 
 _RIGE_API i32_t chr_is_ascii (i32_t chr) ;
 _RIGE_API i32_t chr_to_ascii (i32_t chr) ;
@@ -141,4 +180,562 @@ RIGE_VEC_DECL(i64)
 # define vec_dot(_a, _b) ( (_a).x * (_b).x + (_a).y * (_b).y )
 # define vec_norm(_a)    ( sqrt(vec_dot((_a), (_a))) )
 
+typedef struct strbuf_s strbuf_t ;
+
+struct strbuf_s {
+  chr_t * data     ;
+  usiz_t  size     ;
+  usiz_t  capacity ;
+  i32_t   owned    ;
+} ;
+
+_RIGE_API void strbuf_init (strbuf_t * sb) ;
+_RIGE_API void strbuf_init_with (strbuf_t * sb, ptr_t ptr, usiz_t n) ;
+_RIGE_API void strbuf_free (strbuf_t * sb) ;
+_RIGE_API void strbuf_clear (strbuf_t * sb) ;
+_RIGE_API usiz_t strbuf_reserve (strbuf_t * sb, usiz_t n) ;
+_RIGE_API usiz_t strbuf_append (strbuf_t * sb, const cstr_t cstr) ;
+_RIGE_API usiz_t strbuf_n_append (strbuf_t * sb, const cstr_t cstr, usiz_t n) ;
+_RIGE_API usiz_t strbuf_append_str (strbuf_t * sb, const str_t * str) ;
+_RIGE_API usiz_t strbuf_append_chr (strbuf_t * sb, chr_t chr) ;
+_RIGE_API usiz_t strbuf_append_u64 (strbuf_t * sb, u64_t val, i32_t base) ;
+_RIGE_API usiz_t strbuf_append_i64 (strbuf_t * sb, i64_t val, i32_t base) ;
+_RIGE_API str_t strbuf_to_str (strbuf_t * sb) ;
+
+# define UTF8_MAX_SIZE 4
+
+_RIGE_API usiz_t utf8_decode (const ptr_t ptr, usiz_t n, i32_t * cp) ;
+_RIGE_API usiz_t utf8_encode (ptr_t ptr, usiz_t n, i32_t cp) ;
+_RIGE_API usiz_t utf8_valid (const ptr_t ptr, usiz_t n) ;
+_RIGE_API usiz_t utf8_count (const ptr_t ptr, usiz_t n) ;
+_RIGE_API i32_t utf8_cp_width (i32_t cp) ;
+_RIGE_API usiz_t utf8_width (const ptr_t ptr, usiz_t n) ;
+_RIGE_API usiz_t utf8_find_cntrl (const ptr_t ptr, usiz_t n) ;
+
+/* buffer size that fits any `i64_t`/`u64_t` in any base plus terminator */
+# define NUM_MAX_SIZE 66
+
+/* parsing reads at most `n` bytes and stops at the terminator, `base`
+ * follows `chr_to_digit` and 0 takes the radix from a `0x`/`0o`/`0b`
+ * prefix (decimal without one) accepting letters of both cases
+ */
+_RIGE_API usiz_t num_parse_u64 (const cstr_t cstr, usiz_t n, i32_t base, u64_t * val) ;
+_RIGE_API usiz_t num_parse_i64 (const cstr_t cstr, usiz_t n, i32_t base, i64_t * val) ;
+_RIGE_API usiz_t num_fmt_u64 (cstr_t dst, usiz_t n, u64_t val, i32_t base) ;
+_RIGE_API usiz_t num_fmt_i64 (cstr_t dst, usiz_t n, i64_t val, i32_t base) ;
+
+# define RIGE_CACHE_LINE 64
+
+enum {
+  CHAN_SPSC     = 0x0000 ,
+  CHAN_MPSC     = 0x0001 ,
+  CHAN_BLOCKING = 0x0002
+} ;
+
+typedef struct chan_s chan_t ;
+
+/* bounded lock-free ring of fixed-size messages with a single consumer,
+ * the indices written by different threads live on different lines
+ */
+struct chan_s {
+  _Alignas(RIGE_CACHE_LINE) _Atomic usiz_t tail       ;
+  usiz_t                                   head_cache ;
+  _Alignas(RIGE_CACHE_LINE) _Atomic usiz_t head       ;
+  usiz_t                                   tail_cache ;
+  _Alignas(RIGE_CACHE_LINE) _Atomic u32_t  signal     ;
+  _Atomic u32_t                            waiters    ;
+  _Alignas(RIGE_CACHE_LINE) u8_t *         data       ;
+  _Atomic usiz_t *                         seq        ;
+  usiz_t                                   elem_size  ;
+  usiz_t                                   mask       ;
+  i32_t                                    flags      ;
+} ;
+
+_RIGE_API usiz_t chan_init (chan_t * ch, usiz_t elem_size, usiz_t n, i32_t flags) ;
+_RIGE_API void chan_free (chan_t * ch) ;
+_RIGE_API usiz_t chan_push (chan_t * ch, const ptr_t src, usiz_t n) ;
+_RIGE_API usiz_t chan_pop (chan_t * ch, ptr_t dst, usiz_t n) ;
+_RIGE_API usiz_t chan_wait_pop (chan_t * ch, ptr_t dst, usiz_t n) ;
+
+# define EVAL_BATCH 64
+
+/* features of a board from the point of view of the player to move */
+enum {
+  EVAL_BORDER_RATIO , /* own armies over enemy armies on the borders */
+  EVAL_CONTINENT    , /* sum of the owned fraction of every continent */
+  EVAL_INCOME       , /* reinforcements at the start of the next turn */
+  EVAL_CARDS        , /* cards in hand */
+  EVAL_FEATURES
+} ;
+
+typedef struct eval_s eval_t ;
+typedef struct eval_batch_s eval_batch_t ;
+
+/* every feature is scored by a two-piece linear function, `weight` up to
+ * `knee` and `slope` past it
+ */
+struct eval_s {
+  f32_t weight [EVAL_FEATURES] ;
+  f32_t knee   [EVAL_FEATURES] ;
+  f32_t slope  [EVAL_FEATURES] ;
+  f32_t bias                   ;
+} ;
+
+/* structure of arrays, one lane per board */
+struct eval_batch_s {
+  _Alignas(RIGE_CACHE_LINE) f32_t feat [EVAL_FEATURES][EVAL_BATCH] ;
+  usiz_t size ;
+} ;
+
+_RIGE_API void eval_init (eval_t * ev) ;
+_RIGE_API usiz_t eval_load (eval_t * ev, const cstr_t path) ;
+_RIGE_API f32_t eval_one (const eval_t * ev, const f32_t * feat) ;
+_RIGE_API usiz_t eval_run (const eval_t * ev, const eval_batch_t * batch, f32_t * out) ;
+
+typedef struct map_s map_t ;
+
+/* territories and their borders, the neighbors of `t` are
+ * `adj[adj_off[t]]` up to `adj[adj_off[t + 1]]`. after `map_reorder`
+ * `to_old`/`to_new` translate from/to the ids of the map file. `cells`
+ * is the terminal layout, the territory of every cell row by row.
+ * `epoch` counts the changes that renumber territories or continents
+ */
+struct map_s {
+  usiz_t  n_terr     ;
+  u32_t * adj_off    ;
+  u32_t * adj        ;
+  u32_t * to_old     ;
+  u32_t * to_new     ;
+  usiz_t  n_cont     ;
+  u32_t * cont       ;
+  u32_t * cont_size  ;
+  u32_t * cont_bonus ;
+  i32v_t  size       ;
+  u32_t * cells      ;
+  u32_t   epoch      ;
+} ;
+
+_RIGE_API usiz_t map_init (map_t * map, usiz_t n_terr, const u32_t * edges, usiz_t n_edges) ;
+_RIGE_API void map_free (map_t * map) ;
+_RIGE_API u32_t map_hash (const map_t * map) ;
+_RIGE_API usiz_t map_set_continents (map_t * map, usiz_t n_cont, const u32_t * cont, const u32_t * bonus) ;
+_RIGE_API usiz_t map_generate (map_t * map, usiz_t n_terr, usiz_t n_cont, i32v_t size, u64_t seed, usiz_t n_threads) ;
+_RIGE_API usiz_t map_save (const map_t * map, const cstr_t path) ;
+_RIGE_API usiz_t map_load (map_t * map, const cstr_t path) ;
+_RIGE_API usiz_t map_reorder (map_t * map) ;
+_RIGE_API usiz_t map_permute (const map_t * map, ptr_t ptr, usiz_t elem_size) ;
+_RIGE_API u32_t map_to_old (const map_t * map, u32_t terr) ;
+_RIGE_API u32_t map_to_new (const map_t * map, u32_t terr) ;
+
+/* fixed-size territory sets, one bit per territory. with the size known
+ * at compile time every loop has a constant bound, so `bset64_t` is a
+ * single word and the 42 territories of the classic map need no loop at
+ * all. `_adj` builds the neighbor masks of a map, `_border` and
+ * `_attacks` are the set-based move generation.
+ *
+ * a position on such a map is one set per player plus the armies.
+ * `_map` copies the neighbor and continent masks of a map into arrays of
+ * constant size, `_owned` turns the owners of a `board_t` into a set and
+ * `_income`/`_features` are `board_income`/`board_features` on sets. maps
+ * larger than 128 territories use `map_attacks` and the `board_t` API
+ */
+
+# define _RIGE_BSET(_bits, _name) bset ## _bits ## _ ## _name
+# define _RIGE_BSET_WORDS(_bits)  (((_bits) + 63) / 64)
+
+# define RIGE_BSET_DECL(_bits)                                                                 \
+  typedef struct _RIGE_BSET(_bits, s) _RIGE_BSET(_bits, t) ;                                   \
+                                                                                               \
+  struct _RIGE_BSET(_bits, s) {                                                                \
+    u64_t w [_RIGE_BSET_WORDS(_bits)] ;                                                        \
+  } ;                                                                                          \
+                                                                                               \
+  static inline void _RIGE_BSET(_bits, zero) (_RIGE_BSET(_bits, t) * s)                        \
+  {                                                                                            \
+    for (u32_t i = 0 ; i < _RIGE_BSET_WORDS(_bits) ; ++i)                                      \
+      s->w[i] = 0 ;                                                                            \
+  }                                                                                            \
+                                                                                               \
+  static inline void _RIGE_BSET(_bits, set) (_RIGE_BSET(_bits, t) * s, u32_t i)                \
+  {                                                                                            \
+    s->w[i >> 6] |= (u64_t)1 << (i & 63) ;                                                     \
+  }                                                                                            \
+                                                                                               \
+  static inline void _RIGE_BSET(_bits, reset) (_RIGE_BSET(_bits, t) * s, u32_t i)              \
+  {                                                                                            \
+    s->w[i >> 6] &= ~((u64_t)1 << (i & 63)) ;                                                  \
+  }                                                                                            \
+                                                                                               \
+  static inline i32_t _RIGE_BSET(_bits, test) (const _RIGE_BSET(_bits, t) * s, u32_t i)        \
+  {                                                                                            \
+    return 0 != (s->w[i >> 6] & ((u64_t)1 << (i & 63))) ;                                      \
+  }                                                                                            \
+                                                                                               \
+  static inline _RIGE_BSET(_bits, t) _RIGE_BSET(_bits, and) (                                  \
+    _RIGE_BSET(_bits, t) a, _RIGE_BSET(_bits, t) b                                             \
+  )                                                                                            \
+  {                                                                                            \
+    for (u32_t i = 0 ; i < _RIGE_BSET_WORDS(_bits) ; ++i)                                      \
+      a.w[i] &= b.w[i] ;                                                                       \
+                                                                                               \
+    return a ;                                                                                 \
+  }                                                                                            \
+                                                                                               \
+  static inline _RIGE_BSET(_bits, t) _RIGE_BSET(_bits, or) (                                   \
+    _RIGE_BSET(_bits, t) a, _RIGE_BSET(_bits, t) b                                             \
+  )                                                                                            \
+  {                                                                                            \
+    for (u32_t i = 0 ; i < _RIGE_BSET_WORDS(_bits) ; ++i)                                      \
+      a.w[i] |= b.w[i] ;                                                                       \
+                                                                                               \
+    return a ;                                                                                 \
+  }                                                                                            \
+                                                                                               \
+  static inline _RIGE_BSET(_bits, t) _RIGE_BSET(_bits, andnot) (                               \
+    _RIGE_BSET(_bits, t) a, _RIGE_BSET(_bits, t) b                                             \
+  )                                                                                            \
+  {                                                                                            \
+    for (u32_t i = 0 ; i < _RIGE_BSET_WORDS(_bits) ; ++i)                                      \
+      a.w[i] &= ~b.w[i] ;                                                                      \
+                                                                                               \
+    return a ;                                                                                 \
+  }                                                                                            \
+                                                                                               \
+  static inline i32_t _RIGE_BSET(_bits, any) (const _RIGE_BSET(_bits, t) * s)                  \
+  {                                                                                            \
+    u64_t any = 0 ;                                                                            \
+                                                                                               \
+    for (u32_t i = 0 ; i < _RIGE_BSET_WORDS(_bits) ; ++i)                                      \
+      any |= s->w[i] ;                                                                         \
+                                                                                               \
+    return 0 != any ;                                                                          \
+  }                                                                                            \
+                                                                                               \
+  static inline u32_t _RIGE_BSET(_bits, count) (const _RIGE_BSET(_bits, t) * s)                \
+  {                                                                                            \
+    u32_t count = 0 ;                                                                          \
+                                                                                               \
+    for (u32_t i = 0 ; i < _RIGE_BSET_WORDS(_bits) ; ++i)                                      \
+      count += __builtin_popcountll(s->w[i]) ;                                                 \
+                                                                                               \
+    return count ;                                                                             \
+  }                                                                                            \
+                                                                                               \
+  static inline u32_t _RIGE_BSET(_bits, next) (const _RIGE_BSET(_bits, t) * s, u32_t from)     \
+  {                                                                                            \
+    for (u32_t i = from >> 6 ; i < _RIGE_BSET_WORDS(_bits) ; ++i) {                            \
+      u64_t word = s->w[i] ;                                                                   \
+                                                                                               \
+      if (i == (from >> 6))                                                                    \
+        word &= ~(u64_t)0 << (from & 63) ;                                                     \
+                                                                                               \
+      if (0 != word)                                                                           \
+        return (i << 6) + __builtin_ctzll(word) ;                                              \
+    }                                                                                          \
+                                                                                               \
+    return (u32_t)RIGE_NPOS ;                                                                  \
+  }                                                                                            \
+                                                                                               \
+  static inline usiz_t _RIGE_BSET(_bits, adj) (const map_t * map, _RIGE_BSET(_bits, t) * adj)  \
+  {                                                                                            \
+    if (RIGE_NULL == map || RIGE_NULL == adj || (_bits) < map->n_terr)                         \
+      return RIGE_NPOS ;                                                                       \
+                                                                                               \
+    for (u32_t t = 0 ; t < map->n_terr ; ++t) {                                                \
+      _RIGE_BSET(_bits, zero)(&adj[t]) ;                                                       \
+                                                                                               \
+      for (u32_t i = map->adj_off[t] ; i < map->adj_off[t + 1] ; ++i)                          \
+        _RIGE_BSET(_bits, set)(&adj[t], map->adj[i]) ;                                         \
+    }                                                                                          \
+                                                                                               \
+    return map->n_terr ;                                                                       \
+  }                                                                                            \
+                                                                                               \
+  static inline _RIGE_BSET(_bits, t) _RIGE_BSET(_bits, border) (                               \
+    const _RIGE_BSET(_bits, t) * adj, _RIGE_BSET(_bits, t) own                                 \
+  )                                                                                            \
+  {                                                                                            \
+    _RIGE_BSET(_bits, t) border ;                                                              \
+    u32_t t = _RIGE_BSET(_bits, next)(&own, 0) ;                                               \
+                                                                                               \
+    _RIGE_BSET(_bits, zero)(&border) ;                                                         \
+                                                                                               \
+    while ((u32_t)RIGE_NPOS != t) {                                                            \
+      _RIGE_BSET(_bits, t) enemy = _RIGE_BSET(_bits, andnot)(adj[t], own) ;                    \
+                                                                                               \
+      if (_RIGE_BSET(_bits, any)(&enemy))                                                      \
+        _RIGE_BSET(_bits, set)(&border, t) ;                                                   \
+                                                                                               \
+      t = _RIGE_BSET(_bits, next)(&own, t + 1) ;                                               \
+    }                                                                                          \
+                                                                                               \
+    return border ;                                                                            \
+  }                                                                                            \
+                                                                                               \
+  static inline usiz_t _RIGE_BSET(_bits, attacks) (                                            \
+    const _RIGE_BSET(_bits, t) * adj, _RIGE_BSET(_bits, t) own, _RIGE_BSET(_bits, t) ready,    \
+    u32_t * moves, usiz_t n                                                                    \
+  )                                                                                            \
+  {                                                                                            \
+    usiz_t size = 0 ;                                                                          \
+                                                                                               \
+    ready = _RIGE_BSET(_bits, and)(ready, own) ;                                               \
+                                                                                               \
+    for (u32_t t = _RIGE_BSET(_bits, next)(&ready, 0) ; (u32_t)RIGE_NPOS != t ; ) {            \
+      _RIGE_BSET(_bits, t) enemy = _RIGE_BSET(_bits, andnot)(adj[t], own) ;                    \
+      u32_t e = _RIGE_BSET(_bits, next)(&enemy, 0) ;                                           \
+                                                                                               \
+      for (; (u32_t)RIGE_NPOS != e ; e = _RIGE_BSET(_bits, next)(&enemy, e + 1)) {             \
+        if (n <= size)                                                                         \
+          return size ;                                                                        \
+                                                                                               \
+        moves[2 * size + 0] = t ;                                                              \
+        moves[2 * size + 1] = e ;                                                              \
+        ++size ;                                                                               \
+      }                                                                                        \
+                                                                                               \
+      t = _RIGE_BSET(_bits, next)(&ready, t + 1) ;                                             \
+    }                                                                                          \
+                                                                                               \
+    return size ;                                                                              \
+  }                                                                                            \
+                                                                                               \
+  typedef struct _RIGE_BSET(_bits, map_s) _RIGE_BSET(_bits, map_t) ;                           \
+                                                                                               \
+  /* the territory sets of a map in arrays of constant size */                                 \
+  struct _RIGE_BSET(_bits, map_s) {                                                            \
+    _RIGE_BSET(_bits, t) adj    [_bits] ;                                                      \
+    _RIGE_BSET(_bits, t) cont   [_bits] ;                                                      \
+    u32_t                size   [_bits] ;                                                      \
+    u32_t                bonus  [_bits] ;                                                      \
+    u32_t                n_cont         ;                                                      \
+  } ;                                                                                          \
+                                                                                               \
+  static inline usiz_t _RIGE_BSET(_bits, map) (const map_t * map, _RIGE_BSET(_bits, map_t) * m)\
+  {                                                                                            \
+    if (RIGE_NULL == m || RIGE_NPOS == _RIGE_BSET(_bits, adj)(map, m->adj))                    \
+      return RIGE_NPOS ;                                                                       \
+                                                                                               \
+    /* no continent is empty, so there are at most `_bits` of them */                          \
+    m->n_cont = (u32_t)map->n_cont ;                                                           \
+                                                                                               \
+    for (u32_t c = 0 ; c < map->n_cont ; ++c) {                                                \
+      _RIGE_BSET(_bits, zero)(&m->cont[c]) ;                                                   \
+      m->size[c]  = map->cont_size[c] ;                                                        \
+      m->bonus[c] = map->cont_bonus[c] ;                                                       \
+    }                                                                                          \
+                                                                                               \
+    for (u32_t t = 0 ; t < map->n_terr ; ++t)                                                  \
+      _RIGE_BSET(_bits, set)(&m->cont[map->cont[t]], t) ;                                      \
+                                                                                               \
+    return map->n_terr ;                                                                       \
+  }                                                                                            \
+                                                                                               \
+  static inline _RIGE_BSET(_bits, t) _RIGE_BSET(_bits, owned) (                                \
+    const u8_t * owner, usiz_t n_terr, u8_t player                                             \
+  )                                                                                            \
+  {                                                                                            \
+    _RIGE_BSET(_bits, t) own ;                                                                 \
+                                                                                               \
+    _RIGE_BSET(_bits, zero)(&own) ;                                                            \
+                                                                                               \
+    for (u32_t t = 0 ; t < n_terr && t < (_bits) ; ++t)                                        \
+      own.w[t >> 6] |= (u64_t)(player == owner[t]) << (t & 63) ;                               \
+                                                                                               \
+    return own ;                                                                               \
+  }                                                                                            \
+                                                                                               \
+  static inline u32_t _RIGE_BSET(_bits, income) (                                              \
+    const _RIGE_BSET(_bits, map_t) * m, _RIGE_BSET(_bits, t) own                               \
+  )                                                                                            \
+  {                                                                                            \
+    u32_t n_owned = _RIGE_BSET(_bits, count)(&own) ;                                           \
+    u32_t bonus = 0 ;                                                                          \
+                                                                                               \
+    if (0 == n_owned)                                                                          \
+      return 0 ;                                                                               \
+                                                                                               \
+    for (u32_t c = 0 ; c < m->n_cont ; ++c) {                                                  \
+      _RIGE_BSET(_bits, t) miss = _RIGE_BSET(_bits, andnot)(m->cont[c], own) ;                 \
+                                                                                               \
+      if (0 == _RIGE_BSET(_bits, any)(&miss))                                                  \
+        bonus += m->bonus[c] ;                                                                 \
+    }                                                                                          \
+                                                                                               \
+    return (n_owned < 9 ? 3 : n_owned / 3) + bonus ;                                           \
+  }                                                                                            \
+                                                                                               \
+  static inline void _RIGE_BSET(_bits, features) (                                             \
+    const _RIGE_BSET(_bits, map_t) * m, _RIGE_BSET(_bits, t) own,                              \
+    const u32_t * armies, f32_t * feat                                                         \
+  )                                                                                            \
+  {                                                                                            \
+    _RIGE_BSET(_bits, t) front ;                                                               \
+    u64_t own_armies = 0 ;                                                                     \
+    u64_t enemy_armies = 0 ;                                                                   \
+    f32_t continent = 0.0f ;                                                                   \
+                                                                                               \
+    _RIGE_BSET(_bits, zero)(&front) ;                                                          \
+                                                                                               \
+    for (u32_t t = _RIGE_BSET(_bits, next)(&own, 0) ; (u32_t)RIGE_NPOS != t ; ) {              \
+      _RIGE_BSET(_bits, t) enemy = _RIGE_BSET(_bits, andnot)(m->adj[t], own) ;                 \
+                                                                                               \
+      if (_RIGE_BSET(_bits, any)(&enemy)) {                                                    \
+        own_armies += armies[t] ;                                                              \
+        front = _RIGE_BSET(_bits, or)(front, enemy) ;                                          \
+      }                                                                                        \
+                                                                                               \
+      t = _RIGE_BSET(_bits, next)(&own, t + 1) ;                                               \
+    }                                                                                          \
+                                                                                               \
+    for (u32_t e = _RIGE_BSET(_bits, next)(&front, 0) ; (u32_t)RIGE_NPOS != e ; ) {            \
+      enemy_armies += armies[e] ;                                                              \
+      e = _RIGE_BSET(_bits, next)(&front, e + 1) ;                                             \
+    }                                                                                          \
+                                                                                               \
+    for (u32_t c = 0 ; c < m->n_cont ; ++c) {                                                  \
+      _RIGE_BSET(_bits, t) mine = _RIGE_BSET(_bits, and)(m->cont[c], own) ;                    \
+                                                                                               \
+      continent += (f32_t)_RIGE_BSET(_bits, count)(&mine) / (f32_t)m->size[c] ;                \
+    }                                                                                          \
+                                                                                               \
+    u64_t enemy = 0 == enemy_armies ? 1 : enemy_armies ;                                       \
+                                                                                               \
+    feat[EVAL_BORDER_RATIO] = (f32_t)own_armies / (f32_t)enemy ;                               \
+    feat[EVAL_CONTINENT]    = continent ;                                                      \
+    feat[EVAL_INCOME]       = (f32_t)_RIGE_BSET(_bits, income)(m, own) ;                       \
+  }
+
+RIGE_BSET_DECL(64)
+RIGE_BSET_DECL(128)
+
+_RIGE_API usiz_t map_attacks (const map_t * map, const u8_t * owner, const u32_t * armies, u8_t player, u32_t * moves, usiz_t n) ;
+
+# define BOARD_NONE 0xFF
+
+typedef struct board_s board_t ;
+
+/* owners and armies of a match, with the counters reinforcements are
+ * made of kept up to date by `board_set_owner`. `cont_owned` has
+ * `n_cont` entries per player. the map must not change while a board
+ * uses it: `map_set_continents` or `map_reorder` bump `map->epoch` and
+ * the board then refuses to update. `board_features` fills the features
+ * of `eval_t` but `EVAL_CARDS`, which is not on the board
+ */
+struct board_s {
+  const map_t * map        ;
+  u32_t         epoch      ;
+  usiz_t        n_players  ;
+  usiz_t        n_cont     ;
+  u8_t *        owner      ;
+  u32_t *       armies     ;
+  u32_t *       n_owned    ;
+  u32_t *       cont_owned ;
+  u32_t *       bonus      ;
+} ;
+
+_RIGE_API usiz_t board_init (board_t * board, const map_t * map, usiz_t n_players) ;
+_RIGE_API void board_free (board_t * board) ;
+_RIGE_API i32_t board_set_owner (board_t * board, u32_t terr, u8_t player, u8_t * prev_owner) ;
+_RIGE_API u32_t board_income (const board_t * board, u8_t player) ;
+_RIGE_API u32_t board_income_scan (const board_t * board, u8_t player) ;
+_RIGE_API i32_t board_features (const board_t * board, u8_t player, f32_t * feat) ;
+_RIGE_API i32_t board_check (const board_t * board) ;
+
+# define DIST_INF 0xFF
+
+typedef struct dist_s dist_t ;
+
+/* hop distances between territories, saturated at `DIST_INF`. exact when
+ * `n_land` is 0, otherwise only the rows of the `n_land` landmarks are
+ * kept and distances are estimated from them. `dist_cache` is the step to
+ * run after `map_load`: it reads `<map_path>.dist` when it was written
+ * for the same map and budget, otherwise it builds the table and writes
+ * the file
+ */
+struct dist_s {
+  usiz_t  n_terr ;
+  usiz_t  n_land ;
+  u32_t * land   ;
+  u8_t *  data   ;
+} ;
+
+_RIGE_API usiz_t dist_build (dist_t * dist, const map_t * map, usiz_t max_bytes, usiz_t n_threads) ;
+_RIGE_API void dist_free (dist_t * dist) ;
+_RIGE_API u32_t dist_get (const dist_t * dist, u32_t from, u32_t to) ;
+_RIGE_API u32_t dist_nearest (const dist_t * dist, u32_t from, const u32_t * set, usiz_t n) ;
+_RIGE_API usiz_t dist_save (const dist_t * dist, const cstr_t path, u32_t hash) ;
+_RIGE_API usiz_t dist_load (dist_t * dist, const cstr_t path, u32_t hash) ;
+_RIGE_API usiz_t dist_cache (dist_t * dist, const map_t * map, const cstr_t map_path, usiz_t max_bytes, usiz_t n_threads) ;
+
+# define DSET_HEAD_SIZE 32
+
+typedef struct dset_s dset_t ;
+
+/* columnar dataset writer, rows are buffered into chunks of `f32_t`
+ * columns and a background thread writes the full ones. use one writer
+ * per simulation thread, each on its own file. `dset_push` returns the
+ * index of the row in the file, or `RIGE_NPOS` once the writer failed
+ */
+struct dset_s {
+  FILE *          file       ;
+  usiz_t          n_cols     ;
+  usiz_t          chunk_rows ;
+  f32_t *         buf [2]    ;
+  usiz_t          fill       ;
+  usiz_t          rows       ;
+  usiz_t          pending    ;
+  u64_t           total      ;
+  i32_t           done       ;
+  _Atomic i32_t   error      ;
+  pthread_t       thread     ;
+  pthread_mutex_t lock       ;
+  pthread_cond_t  cond       ;
+} ;
+
+_RIGE_API usiz_t dset_open (dset_t * ds, const cstr_t path, usiz_t n_cols, usiz_t chunk_rows) ;
+_RIGE_API usiz_t dset_push (dset_t * ds, const f32_t * row) ;
+_RIGE_API u64_t dset_close (dset_t * ds) ;
+_RIGE_API usiz_t dset_chunk (const ptr_t ptr, usiz_t n, u32_t * n_cols, u64_t * n_rows) ;
+_RIGE_API u32_t mem_crc32 (const ptr_t ptr, usiz_t n) ;
+
+_RIGE_API u64_t bits_get (const u64_t * words, usiz_t pos, u32_t width) ;
+_RIGE_API void bits_set (u64_t * words, usiz_t pos, u32_t width, u64_t val) ;
+
+typedef u64_t handle_t ;
+typedef struct pool_s pool_t ;
+
+/* packed game states of one map. owners take 3 bits, armies 2 bits of
+ * bucket plus 2, 4, 8 or 32 bits of value and every player's cards are a
+ * `n_cards` bits mask. states of the same size in words share a slab,
+ * handles go through a table so they survive a state changing slab
+ */
+struct pool_s {
+  usiz_t    n_terr     ;
+  usiz_t    n_players  ;
+  usiz_t    n_cards    ;
+  usiz_t    max_words  ;
+  u64_t **  slab       ;
+  usiz_t *  slab_used  ;
+  usiz_t *  slab_cap   ;
+  u32_t **  slab_free  ;
+  usiz_t *  slab_nfree ;
+  u32_t *   ent_slot   ;
+  u32_t *   ent_gen    ;
+  u8_t *    ent_words  ;
+  usiz_t    ent_used   ;
+  usiz_t    ent_cap    ;
+  u32_t *   ent_free   ;
+  usiz_t    ent_nfree  ;
+  usiz_t    n_states   ;
+} ;
+
+_RIGE_API usiz_t pool_init (pool_t * pool, usiz_t n_terr, usiz_t n_players, usiz_t n_cards) ;
+_RIGE_API void pool_free (pool_t * pool) ;
+_RIGE_API handle_t pool_put (pool_t * pool, const u8_t * owner, const u32_t * armies, const u64_t * cards) ;
+_RIGE_API usiz_t pool_get (const pool_t * pool, handle_t h, u8_t * owner, u32_t * armies, u64_t * cards) ;
+_RIGE_API usiz_t pool_set (pool_t * pool, handle_t h, const u8_t * owner, const u32_t * armies, const u64_t * cards) ;
+_RIGE_API void pool_del (pool_t * pool, handle_t h) ;
+_RIGE_API usiz_t pool_bytes (const pool_t * pool) ;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,451 @@
+#include "rige.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* checks of the RiGE invariants that are cheap to state and easy to
+ * break, self-contained:
+ *
+ *   cc -O2 -o test test.c rige.c -lm -lpthread && ./test
+ *
+ * every check prints one line, the exit status is 1 if any failed
+ */
+
+static usiz_t _test_failed = 0 ;
+
+static void _test_report (const cstr_t name, i32_t ok)
+{
+  printf("%-32s %s\n", name, ok ? "ok" : "FAILED") ;
+
+  if (!ok) {
+    ++_test_failed ;
+  }
+}
+
+static u64_t _test_rand (u64_t * state)
+{
+  /* xorshift64, the same sequence on every run */
+  *state ^= *state << 13 ;
+  *state ^= *state >> 7 ;
+  *state ^= *state << 17 ;
+
+  return *state ;
+}
+
+/* ----------------------------------------------------------------
+ * board
+ */
+
+/* `board_income` from the counters against `board_income_scan` from
+ * scratch, after every one of `n_moves` random owner changes
+ */
+static i32_t _test_board_income (const map_t * map, usiz_t n_players, usiz_t n_moves, u64_t seed)
+{
+  board_t board ;
+
+  if (RIGE_NPOS == board_init(&board, map, n_players))
+    return 0 ;
+
+  i32_t ok = 1 ;
+
+  for (usiz_t i = 0 ; ok && i < n_moves ; ++i) {
+    u32_t terr = (u32_t)(_test_rand(&seed) % map->n_terr) ;
+    u64_t r = _test_rand(&seed) % (n_players + 1) ;
+    u8_t player = n_players == r ? BOARD_NONE : (u8_t)r ;
+
+    if (0 != board_set_owner(&board, terr, player, RIGE_NULL)) {
+      ok = 0 ;
+      break ;
+    }
+
+    for (u8_t p = 0 ; p < n_players ; ++p)
+      ok = ok && board_income(&board, p) == board_income_scan(&board, p) ;
+  }
+
+  /* a whole map for player 0, every continent counted once */
+  for (u32_t t = 0 ; ok && t < map->n_terr ; ++t)
+    ok = 0 == board_set_owner(&board, t, 0, RIGE_NULL) ;
+
+  ok = ok && board_income(&board, 0) == board_income_scan(&board, 0) && 0 == board_check(&board) ;
+
+  board_free(&board) ;
+
+  return ok ;
+}
+
+static void _test_board (void)
+{
+  map_t map ;
+
+  if (RIGE_NPOS == map_generate(&map, 42, 6, (i32v_t){ 80, 24 }, 7, 1)) {
+    _test_report("board: map_generate", 0) ;
+    return ;
+  }
+
+  _test_report("board: income, 42 territories", _test_board_income(&map, 4, 20000, 1)) ;
+
+  /* the counters do not follow a map that changes under them */
+  board_t board ;
+
+  if (RIGE_NPOS == board_init(&board, &map, 2)) {
+    _test_report("board: init", 0) ;
+  } else {
+    i32_t ok = 0 == board_set_owner(&board, 0, 1, RIGE_NULL) ;
+
+    map_reorder(&map) ;
+
+    ok = ok && -1 == board_set_owner(&board, 0, 0, RIGE_NULL) && -1 == board_check(&board) ;
+    _test_report("board: stale after map_reorder", ok) ;
+
+    board_free(&board) ;
+  }
+
+  _test_report("board: income, reordered", _test_board_income(&map, 3, 20000, 2)) ;
+
+  map_free(&map) ;
+
+  if (RIGE_NPOS == map_generate(&map, 1000, 40, (i32v_t){ 400, 200 }, 11, 1)) {
+    _test_report("board: map_generate", 0) ;
+    return ;
+  }
+
+  _test_report("board: income, 1000 territories", _test_board_income(&map, 6, 5000, 3)) ;
+
+  map_free(&map) ;
+}
+
+static void _test_continents (void)
+{
+  /* a path of 4 territories */
+  const u32_t edges [] = { 0, 1, 1, 2, 2, 3 } ;
+  const u32_t bonus [] = { 2, 3, 5 } ;
+  const u32_t empty [] = { 0, 0, 2, 2 } ;
+  const u32_t full  [] = { 0, 1, 2, 2 } ;
+  map_t map ;
+
+  if (RIGE_NPOS == map_init(&map, 4, edges, 3)) {
+    _test_report("continents: map_init", 0) ;
+    return ;
+  }
+
+  /* nobody can own a continent without territories, so nobody gets it */
+  _test_report("continents: empty rejected", RIGE_NPOS == map_set_continents(&map, 3, empty, bonus)) ;
+  _test_report("continents: all used", 3 == map_set_continents(&map, 3, full, bonus)) ;
+
+  map_free(&map) ;
+}
+
+/* ----------------------------------------------------------------
+ * bset
+ */
+
+#define _TEST_MOVES 1024
+
+/* the set-based income, features and moves of `_bits` against the
+ * `board_t` ones, on `n_pos` random positions of `map`
+ */
+#define _TEST_BSET(_bits)                                                                      \
+  static i32_t _test_bset ## _bits (                                                           \
+    const map_t * map, usiz_t n_players, usiz_t n_pos, u64_t seed                              \
+  )                                                                                            \
+  {                                                                                            \
+    static bset ## _bits ## _map_t m ;                                                         \
+    u32_t moves [2][2 * _TEST_MOVES] ;                                                         \
+    board_t board ;                                                                            \
+                                                                                               \
+    if (RIGE_NPOS == bset ## _bits ## _map(map, &m))                                           \
+      return 0 ;                                                                               \
+                                                                                               \
+    if (RIGE_NPOS == board_init(&board, map, n_players))                                       \
+      return 0 ;                                                                               \
+                                                                                               \
+    i32_t ok = 1 ;                                                                             \
+                                                                                               \
+    for (usiz_t i = 0 ; ok && i < n_pos ; ++i) {                                               \
+      for (u32_t t = 0 ; t < map->n_terr ; ++t) {                                              \
+        board_set_owner(&board, t, (u8_t)(_test_rand(&seed) % n_players), RIGE_NULL) ;         \
+        board.armies[t] = 1 + (u32_t)(_test_rand(&seed) % 4) ;                                 \
+      }                                                                                        \
+                                                                                               \
+      for (u8_t p = 0 ; ok && p < n_players ; ++p) {                                           \
+        bset ## _bits ## _t own = bset ## _bits ## _owned(board.owner, map->n_terr, p) ;       \
+        bset ## _bits ## _t ready ;                                                            \
+        f32_t feat [2][EVAL_FEATURES] ;                                                        \
+                                                                                               \
+        bset ## _bits ## _zero(&ready) ;                                                       \
+                                                                                               \
+        for (u32_t t = 0 ; t < map->n_terr ; ++t) {                                            \
+          if (1 < board.armies[t])                                                             \
+            bset ## _bits ## _set(&ready, t) ;                                                 \
+        }                                                                                      \
+                                                                                               \
+        usiz_t n = map_attacks(map, board.owner, board.armies, p, moves[0], _TEST_MOVES) ;     \
+                                                                                               \
+        ok = ok && n == bset ## _bits ## _attacks(m.adj, own, ready, moves[1], _TEST_MOVES) ;  \
+        ok = ok && 0 == memcmp(moves[0], moves[1], 2 * n * sizeof(u32_t)) ;                    \
+        ok = ok && board_income(&board, p) == bset ## _bits ## _income(&m, own) ;              \
+                                                                                               \
+        bset ## _bits ## _features(&m, own, board.armies, feat[1]) ;                           \
+                                                                                               \
+        ok = ok && 0 == board_features(&board, p, feat[0]) ;                                   \
+        ok = ok && feat[0][EVAL_BORDER_RATIO] == feat[1][EVAL_BORDER_RATIO] ;                  \
+        ok = ok && feat[0][EVAL_CONTINENT] == feat[1][EVAL_CONTINENT] ;                        \
+        ok = ok && feat[0][EVAL_INCOME] == feat[1][EVAL_INCOME] ;                              \
+      }                                                                                        \
+    }                                                                                          \
+                                                                                               \
+    board_free(&board) ;                                                                       \
+                                                                                               \
+    return ok ;                                                                                \
+  }
+
+_TEST_BSET(64)
+_TEST_BSET(128)
+
+static void _test_bset (void)
+{
+  map_t map ;
+
+  if (RIGE_NPOS == map_generate(&map, 42, 6, (i32v_t){ 80, 24 }, 13, 1)) {
+    _test_report("bset: map_generate", 0) ;
+    return ;
+  }
+
+  _test_report("bset64: 42 territories", _test_bset64(&map, 3, 500, 4)) ;
+  _test_report("bset128: 42 territories", _test_bset128(&map, 3, 500, 5)) ;
+
+  map_free(&map) ;
+
+  if (RIGE_NPOS == map_generate(&map, 120, 10, (i32v_t){ 160, 48 }, 17, 1)) {
+    _test_report("bset: map_generate", 0) ;
+    return ;
+  }
+
+  _test_report("bset128: 120 territories", _test_bset128(&map, 5, 500, 6)) ;
+
+  map_free(&map) ;
+}
+
+/* ----------------------------------------------------------------
+ * dist
+ */
+
+#define _TEST_DIST_PATH "test.dist"
+
+/* overwrites the `u64_t` at `offset` of the cache file */
+static i32_t _test_dist_patch (long offset, u64_t val)
+{
+  FILE * file = fopen(_TEST_DIST_PATH, "r+b") ;
+
+  if (RIGE_NULL == file)
+    return 0 ;
+
+  i32_t ok = 0 == fseek(file, offset, SEEK_SET) && 1 == fwrite(&val, sizeof(u64_t), 1, file) ;
+
+  return 0 == fclose(file) && ok ;
+}
+
+static void _test_dist_load (void)
+{
+  map_t map ;
+  dist_t dist ;
+  dist_t back ;
+
+  if (RIGE_NPOS == map_generate(&map, 200, 8, (i32v_t){ 120, 40 }, 19, 1)) {
+    _test_report("dist: map_generate", 0) ;
+    return ;
+  }
+
+  u32_t hash = map_hash(&map) ;
+  i32_t ok = RIGE_NPOS != dist_build(&dist, &map, 1 << 20, 2) ;
+
+  ok = ok && RIGE_NPOS != dist_save(&dist, _TEST_DIST_PATH, hash) ;
+  ok = ok && RIGE_NPOS != dist_load(&back, _TEST_DIST_PATH, hash) ;
+  ok = ok && 0 == memcmp(dist.data, back.data, dist.n_terr * dist.n_terr) ;
+  _test_report("dist: save and load", ok) ;
+
+  dist_free(&back) ;
+
+  /* 10 landmark rows */
+  dist_t land ;
+
+  ok = RIGE_NPOS != dist_build(&land, &map, 10 * 200, 2) ;
+  ok = ok && RIGE_NPOS != dist_save(&land, _TEST_DIST_PATH, hash) ;
+  ok = ok && RIGE_NPOS != dist_load(&back, _TEST_DIST_PATH, hash) ;
+  ok = ok && 10 == back.n_land && 0 == memcmp(land.land, back.land, 10 * sizeof(u32_t)) ;
+  ok = ok && 0 == memcmp(land.data, back.data, 10 * 200) ;
+  _test_report("dist: landmarks save and load", ok) ;
+
+  dist_free(&back) ;
+
+  /* the threads only share out the rows, the landmarks do not change */
+  ok = RIGE_NPOS != dist_build(&back, &map, 10 * 200, 1) ;
+  ok = ok && 0 == memcmp(land.land, back.land, 10 * sizeof(u32_t)) ;
+  ok = ok && 0 == memcmp(land.data, back.data, 10 * 200) ;
+  _test_report("dist: landmarks, 1 and 2 threads", ok) ;
+
+  dist_free(&back) ;
+  dist_free(&land) ;
+  ok = RIGE_NPOS != dist_save(&dist, _TEST_DIST_PATH, hash) ;
+
+  /* `n_terr` and `n_land` follow the 3 `u32_t` of the header, sizes that
+   * do not match the file are rejected before anything is allocated
+   */
+  static const u64_t bad [][2] = {
+    { 0 , 0 } , { 201 , 0 } , { 199 , 0 } , { 1ull << 32 , 0 } , { 1ull << 40 , 0 } ,
+    { 200 , 201 } , { 200 , 1ull << 62 } , { ~0ull , ~0ull }
+  } ;
+
+  for (usiz_t i = 0 ; i < sizeof(bad) / sizeof(bad[0]) ; ++i) {
+    ok = ok && _test_dist_patch(12, bad[i][0]) && _test_dist_patch(20, bad[i][1]) ;
+    ok = ok && RIGE_NPOS == dist_load(&back, _TEST_DIST_PATH, hash) ;
+  }
+
+  _test_report("dist: bad sizes rejected", ok) ;
+
+  remove(_TEST_DIST_PATH) ;
+  dist_free(&dist) ;
+  map_free(&map) ;
+}
+
+#define _TEST_MAP_PATH "test.map"
+
+static void _test_dist_cache (void)
+{
+  map_t map ;
+  map_t other ;
+  dist_t built ;
+  dist_t cached ;
+
+  if (
+    RIGE_NPOS == map_generate(&map, 300, 8, (i32v_t){ 150, 50 }, 23, 1) ||
+    RIGE_NPOS == map_generate(&other, 300, 8, (i32v_t){ 150, 50 }, 29, 1)
+  ) {
+    _test_report("dist: map_generate", 0) ;
+    return ;
+  }
+
+  remove(_TEST_MAP_PATH ".dist") ;
+
+  /* the first call writes the cache, the second reads it */
+  i32_t ok = RIGE_NPOS != dist_cache(&built, &map, _TEST_MAP_PATH, 1 << 20, 2) ;
+  FILE * file = fopen(_TEST_MAP_PATH ".dist", "rb") ;
+
+  ok = ok && RIGE_NULL != file ;
+
+  if (RIGE_NULL != file) {
+    fclose(file) ;
+  }
+
+  ok = ok && RIGE_NPOS != dist_cache(&cached, &map, _TEST_MAP_PATH, 1 << 20, 2) ;
+  ok = ok && 0 == cached.n_land && 0 == memcmp(built.data, cached.data, 300 * 300) ;
+  _test_report("dist: cache written and read", ok) ;
+
+  dist_free(&cached) ;
+
+  /* another budget or another map under the same name are rebuilt */
+  ok = RIGE_NPOS != dist_cache(&cached, &map, _TEST_MAP_PATH, 300 * 12, 2) ;
+  ok = ok && 12 == cached.n_land ;
+  dist_free(&cached) ;
+
+  dist_free(&built) ;
+
+  ok = ok && RIGE_NPOS != dist_cache(&cached, &other, _TEST_MAP_PATH, 1 << 20, 2) ;
+  ok = ok && RIGE_NPOS != dist_build(&built, &other, 1 << 20, 1) ;
+  ok = ok && 0 == memcmp(built.data, cached.data, 300 * 300) ;
+  _test_report("dist: stale cache rebuilt", ok) ;
+
+  remove(_TEST_MAP_PATH ".dist") ;
+  dist_free(&built) ;
+  dist_free(&cached) ;
+  map_free(&map) ;
+  map_free(&other) ;
+}
+
+/* ----------------------------------------------------------------
+ * dset
+ */
+
+#define _TEST_DSET_PATH "test.dset"
+
+static void _test_dset (void)
+{
+  dset_t ds ;
+  f32_t row [3] ;
+  i32_t ok = RIGE_NPOS != dset_open(&ds, _TEST_DSET_PATH, 3, 16) ;
+
+  /* `dset_push` returns the index of the row, across the flushes too */
+  for (usiz_t r = 0 ; r < 40 ; ++r) {
+    row[0] = (f32_t)r ;
+    row[1] = (f32_t)r * 2 ;
+    row[2] = -(f32_t)r ;
+    ok = ok && r == dset_push(&ds, row) ;
+  }
+
+  ok = ok && 40 == dset_close(&ds) ;
+  _test_report("dset: push returns the row", ok) ;
+
+  /* chunks of 16, 16 and 8 rows, the columns one after the other */
+  FILE * file = fopen(_TEST_DSET_PATH, "rb") ;
+  u8_t * data = malloc(1 << 12) ;
+  usiz_t n = RIGE_NULL == file ? 0 : fread(data, 1, 1 << 12, file) ;
+  u64_t total = 0 ;
+
+  for (usiz_t pos = 0 ; ok && pos < n ; ) {
+    u32_t n_cols = 0 ;
+    u64_t n_rows = 0 ;
+    usiz_t size = dset_chunk(data + pos, n - pos, &n_cols, &n_rows) ;
+
+    ok = RIGE_NPOS != size && 3 == n_cols && (40 - total < 16 ? 40 - total : 16) == n_rows ;
+
+    for (u64_t r = 0 ; ok && r < n_rows ; ++r) {
+      f32_t col [3] ;
+
+      for (usiz_t c = 0 ; c < 3 ; ++c)
+        memcpy(&col[c], data + pos + DSET_HEAD_SIZE + (c * n_rows + r) * sizeof(f32_t), sizeof(f32_t)) ;
+
+      ok = (f32_t)(total + r) == col[0] && (f32_t)(total + r) * 2 == col[1] && -(f32_t)(total + r) == col[2] ;
+    }
+
+    total += n_rows ;
+    pos += RIGE_NPOS == size ? n : size ;
+  }
+
+  _test_report("dset: chunks read back", ok && 40 == total) ;
+
+  /* a flipped payload byte fails the checksum */
+  data[DSET_HEAD_SIZE] ^= 1 ;
+  _test_report("dset: checksum", 0 < n && RIGE_NPOS == dset_chunk(data, n, RIGE_NULL, RIGE_NULL)) ;
+
+  if (RIGE_NULL != file) {
+    fclose(file) ;
+  }
+
+  free(data) ;
+  remove(_TEST_DSET_PATH) ;
+
+  /* a failed write turns the next pushes into `RIGE_NPOS`, the writer
+   * thread only reports it once it is done with the chunk
+   */
+  if (RIGE_NPOS == dset_open(&ds, "/dev/full", 3, 16))
+    return ;
+
+  usiz_t index = 0 ;
+
+  for (usiz_t r = 0 ; r < 1024 && RIGE_NPOS != index ; ++r)
+    index = dset_push(&ds, row) ;
+
+  _test_report("dset: write error on push", RIGE_NPOS == index && RIGE_NPOS == dset_push(&ds, row)) ;
+  _test_report("dset: write error on close", RIGE_NPOS == dset_close(&ds)) ;
+}
+
+int main (void)
+{
+  _test_continents() ;
+  _test_board() ;
+  _test_bset() ;
+  _test_dist_load() ;
+  _test_dist_cache() ;
+  _test_dset() ;
+
+  return 0 == _test_failed ? 0 : 1 ;
+}